@@ -0,0 +1,187 @@
+#include "Bot.hpp"
+#include "LoadGenerator.hpp"
+#include "MockApiServer.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace bench;
+
+namespace {
+
+namespace net = boost::asio;
+
+struct BenchOptions {
+    LoadOptions load;
+    MockApiOptions api;
+    size_t workers = 0;
+    // Бот запущен отдельно с TG_BOT_API_URL на адрес сервера
+    bool external = false;
+    // Сколько ждать первого getUpdates от бота
+    std::chrono::seconds wait{60};
+};
+
+void PrintUsage() {
+    std::cerr << "Usage: tg-bench [--chats N] [--commands N] [--workers N] [--timeout SEC]\n"
+                 "                [--port PORT] [--latency MS] [--external] [--wait SEC]\n"
+                 "  --latency   delay every API response by MS milliseconds\n"
+                 "  --wait      give up if the bot does not poll within SEC seconds (60)\n"
+                 "  --external  do not start the bot, wait for one started with\n"
+                 "              TG_BOT_API_URL=http://127.0.0.1:<port>"
+              << std::endl;
+}
+
+BenchOptions ParseArgs(int argc, char* argv[]) {
+    BenchOptions options;
+    // Свой бот подключится к любому свободному порту
+    options.api.port = 0;
+    bool port_set = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--external") {
+            options.external = true;
+            continue;
+        }
+        const bool known = arg == "--chats" || arg == "--commands" || arg == "--workers" ||
+                           arg == "--timeout" || arg == "--port" || arg == "--latency" ||
+                           arg == "--wait";
+        if (!known) {
+            throw std::invalid_argument(std::format("Unknown option: {}", arg));
+        }
+        if (i + 1 == argc) {
+            throw std::invalid_argument(std::format("Missing value for {}", arg));
+        }
+        const unsigned long value = std::stoul(argv[++i]);
+        if (arg == "--chats") {
+            options.load.chats = value;
+        } else if (arg == "--commands") {
+            options.load.commands_per_chat = value;
+        } else if (arg == "--workers") {
+            options.workers = value;
+        } else if (arg == "--timeout") {
+            options.load.timeout = std::chrono::seconds(value);
+        } else if (arg == "--wait") {
+            options.wait = std::chrono::seconds(value);
+        } else if (arg == "--latency") {
+            options.api.latency = std::chrono::milliseconds(value);
+        } else {
+            options.api.port = static_cast<unsigned short>(value);
+            port_set = true;
+        }
+    }
+
+    if (options.external && !port_set) {
+        options.api.port = MockApiOptions{}.port;
+    }
+    return options;
+}
+
+// Замер самой обработки: лимиты Telegram на отправку сняты
+bot::BotOptions MakeBotOptions(const std::string& api_url, const std::filesystem::path& storage,
+                               size_t workers) {
+    bot::BotOptions options;
+    options.api_url = api_url;
+    options.storage_dir = storage.string();
+    options.worker_threads = workers;
+    options.send_limits = {1e9, 1e9, 1e9};
+    return options;
+}
+
+void PrintReport(const LoadReport& report) {
+    const auto ms = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    const LatencyStats& latency = report.latency;
+    std::cout << std::format("Commands: {}, replies: {}\n", report.commands, report.replies)
+              << std::format("Elapsed: {:.3f} s, throughput: {:.1f} replies/s\n",
+                             std::chrono::duration<double>(report.elapsed).count(),
+                             report.GetThroughput())
+              << std::format("Latency ms: min {:.2f}, mean {:.2f}, p50 {:.2f}, p90 {:.2f}, "
+                             "p99 {:.2f}, max {:.2f}",
+                             ms(latency.min), ms(latency.mean), ms(latency.p50), ms(latency.p90),
+                             ms(latency.p99), ms(latency.max))
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        options = ParseArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        net::io_context ioc;
+        MockApiServer server(ioc.get_executor(), options.api);
+        server.Listen();
+        LoadGenerator generator(server, options.load);
+        net::co_spawn(ioc, server.Run(), net::detached);
+        std::thread server_thread([&ioc] { ioc.run(); });
+
+        const std::filesystem::path storage =
+            std::filesystem::temp_directory_path() /
+            std::format("tg-bench-{}", Clock::now().time_since_epoch().count());
+        std::optional<bot::Bot> bot;
+        std::thread bot_thread;
+        if (options.external) {
+            std::cout << "Waiting for a bot at " << server.GetUrl() << std::endl;
+        } else {
+            bot.emplace("bench", MakeBotOptions(server.GetUrl(), storage, options.workers));
+            bot_thread = std::thread([&bot] { bot->Start(); });
+        }
+
+        // Нагрузка начинается, когда бот уже опрашивает сервер
+        const Clock::time_point deadline = Clock::now() + options.wait;
+        while (server.GetPollCount() == 0 && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        const bool connected = server.GetPollCount() != 0;
+        LoadReport report;
+        if (connected) {
+            std::cout << std::format("Running {} chats x {} commands", options.load.chats,
+                                     options.load.commands_per_chat)
+                      << std::endl;
+            report = generator.Run();
+        }
+
+        if (bot.has_value()) {
+            bot->Stop();
+            bot_thread.join();
+            bot.reset();
+            std::filesystem::remove_all(storage);
+        }
+        ioc.stop();
+        server_thread.join();
+
+        if (!connected) {
+            std::cerr << std::format("No bot polled {} within {} s", server.GetUrl(),
+                                     options.wait.count())
+                      << std::endl;
+            return 1;
+        }
+        PrintReport(report);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "LoadGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <utility>
+
+namespace bench {
+
+namespace {
+
+// Значение с рангом ceil(p * n), ранги с единицы
+Clock::duration Percentile(const std::vector<Clock::duration>& sorted, double p) {
+    const auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}  // namespace
+
+LatencyStats Summarize(std::vector<Clock::duration> samples) {
+    LatencyStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+
+    std::ranges::sort(samples);
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.mean = std::accumulate(samples.begin(), samples.end(), Clock::duration::zero()) /
+                 static_cast<Clock::duration::rep>(samples.size());
+    stats.p50 = Percentile(samples, 0.5);
+    stats.p90 = Percentile(samples, 0.9);
+    stats.p99 = Percentile(samples, 0.99);
+    return stats;
+}
+
+double LoadReport::GetThroughput() const {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(replies) / seconds : 0;
+}
+
+LoadGenerator::LoadGenerator(MockApiServer& server, LoadOptions options)
+    : server_(server), options_(options), chats_(options_.chats) {
+    server_.SetSendHandler([this](long chat_id, const std::string&) { OnReply(chat_id); });
+}
+
+LoadReport LoadGenerator::Run() {
+    const Clock::time_point start = Clock::now();
+    std::unique_lock lock(mutex_);
+    latencies_.reserve(options_.chats * options_.commands_per_chat);
+    for (size_t i = 0; i < chats_.size(); ++i) {
+        SendNext(i);
+    }
+
+    finished_.wait_until(lock, start + options_.timeout,
+                         [this] { return done_chats_ == chats_.size(); });
+
+    LoadReport report;
+    report.elapsed = Clock::now() - start;
+    for (const ChatState& chat : chats_) {
+        report.commands += chat.sent;
+    }
+    report.replies = latencies_.size();
+    report.latency = Summarize(latencies_);
+    return report;
+}
+
+void LoadGenerator::SendNext(size_t index) {
+    ChatState& chat = chats_[index];
+    if (chat.sent == options_.commands_per_chat) {
+        ++done_chats_;
+        if (done_chats_ == chats_.size()) {
+            finished_.notify_one();
+        }
+        return;
+    }
+
+    chat.waiting = true;
+    chat.sent_at = Clock::now();
+    server_.PushMessage(options_.first_chat_id + static_cast<long>(index), MakeCommand(chat.sent));
+    ++chat.sent;
+}
+
+void LoadGenerator::OnReply(long chat_id) {
+    const Clock::time_point now = Clock::now();
+    std::lock_guard lock(mutex_);
+    const long index = chat_id - options_.first_chat_id;
+    if (index < 0 || static_cast<size_t>(index) >= chats_.size()) {
+        return;
+    }
+
+    // Длинный ответ может прийти несколькими сообщениями: считаем первое
+    ChatState& chat = chats_[static_cast<size_t>(index)];
+    if (!chat.waiting) {
+        return;
+    }
+    chat.waiting = false;
+    latencies_.push_back(now - chat.sent_at);
+    SendNext(static_cast<size_t>(index));
+}
+
+std::string LoadGenerator::MakeCommand(size_t number) {
+    if (number % 2 == 0) {
+        return std::format("/add Задача {}", number / 2 + 1);
+    }
+    return "/list";
+}
+
+}  // namespace bench
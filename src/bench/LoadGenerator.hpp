@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MockApiServer.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+    size_t chats = 100;
+    // Каждый чат отправляет следующую команду, только получив ответ на предыдущую
+    size_t commands_per_chat = 20;
+    // Чаты нумеруются подряд с этого id
+    long first_chat_id = 1;
+    // Ограничение на весь прогон: команды без ответа к этому моменту не учитываются
+    std::chrono::seconds timeout{60};
+};
+
+struct LatencyStats {
+    Clock::duration min{};
+    Clock::duration mean{};
+    Clock::duration p50{};
+    Clock::duration p90{};
+    Clock::duration p99{};
+    Clock::duration max{};
+};
+
+// Перцентили по ближайшему рангу. Для пустой выборки все значения нулевые
+LatencyStats Summarize(std::vector<Clock::duration> samples);
+
+struct LoadReport {
+    size_t commands = 0;
+    size_t replies = 0;
+    Clock::duration elapsed{};
+    // Время от постановки команды в getUpdates до sendMessage с ответом
+    LatencyStats latency;
+
+    // Ответов в секунду
+    double GetThroughput() const;
+};
+
+// Нагрузка на бота через MockApiServer: N чатов шлют команды по кругу
+// (/add, /list) и ждут ответа. Задержка каждой команды - полный путь через
+// бота: длинный опрос, обработка, очередь отправки и sendMessage.
+// Создается до запуска сервера: конструктор задает обработчик sendMessage
+class LoadGenerator {
+ public:
+    LoadGenerator(MockApiServer& server, LoadOptions options);
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    // Блокирует поток до ответа на все команды или до таймаута
+    LoadReport Run();
+
+ private:
+    struct ChatState {
+        size_t sent = 0;
+        bool waiting = false;
+        Clock::time_point sent_at;
+    };
+
+    MockApiServer& server_;
+    LoadOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    std::vector<ChatState> chats_;
+    std::vector<Clock::duration> latencies_;
+    size_t done_chats_ = 0;
+
+    // Вызывается под mutex_
+    void SendNext(size_t index);
+    void OnReply(long chat_id);
+    static std::string MakeCommand(size_t number);
+};
+
+}  // namespace bench
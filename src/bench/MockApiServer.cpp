@@ -0,0 +1,220 @@
+#include "MockApiServer.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/http/status.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace bench {
+
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+using bot::HttpRequest;
+using bot::HttpServerResponse;
+using net::use_awaitable;
+
+namespace {
+
+constexpr std::string_view CONTENT_TYPE = "application/json";
+
+HttpServerResponse MakeResponse(const HttpRequest& request, http::status status,
+                                std::string body) {
+    return bot::MakeHttpResponse(request, status, std::move(body), CONTENT_TYPE);
+}
+
+bot::HttpServerOptions MakeServerOptions(const MockApiOptions& options) {
+    bot::HttpServerOptions server_options;
+    server_options.listen_address = options.listen_address;
+    server_options.port = options.port;
+    server_options.idle_timeout = options.idle_timeout;
+    server_options.body_limit = MockApiServer::MAX_BODY_SIZE;
+    return server_options;
+}
+
+std::string MakeError(http::status status, std::string_view description) {
+    const nlohmann::json error = {{"ok", false},
+                                  {"error_code", static_cast<int>(status)},
+                                  {"description", description}};
+    return error.dump();
+}
+
+long UnixTime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+MockApiServer::MockApiServer(net::any_io_executor executor, MockApiOptions options)
+    : executor_(std::move(executor)),
+      options_(std::move(options)),
+      server_(executor_, MakeServerOptions(options_),
+              [this](const HttpRequest& request) -> net::awaitable<HttpServerResponse> {
+                  if (options_.latency.count() > 0) {
+                      net::steady_timer delay(executor_, options_.latency);
+                      co_await delay.async_wait(use_awaitable);
+                  }
+                  co_return co_await HandleRequest(request);
+              }) {}
+
+void MockApiServer::Stop() {
+    server_.Stop();
+    WakeWaiters();
+}
+
+std::string MockApiServer::GetUrl() const {
+    return std::format("http://{}:{}", options_.listen_address, GetPort());
+}
+
+long MockApiServer::PushMessage(long chat_id, std::string text) {
+    long update_id = 0;
+    {
+        std::lock_guard lock(mutex_);
+        update_id = next_update_id_++;
+        const json update = {
+            {"update_id", update_id},
+            {"message",
+             {{"message_id", update_id},
+              {"date", UnixTime()},
+              {"chat", {{"id", chat_id}, {"type", "private"}}},
+              {"text", text}}}};
+        updates_.push_back({update_id, update.dump()});
+    }
+    // Ждущие getUpdates живут на исполнителе сервера, будим их там же
+    net::post(executor_, [this] { WakeWaiters(); });
+    return update_id;
+}
+
+void MockApiServer::RejectSends(size_t count, std::chrono::seconds retry_after) {
+    reject_retry_after_ = retry_after.count();
+    sends_to_reject_ = count;
+}
+
+net::awaitable<HttpServerResponse> MockApiServer::HandleRequest(const HttpRequest& request) {
+    // Путь вида /bot<token>/<method>
+    const std::string_view target = request.target();
+    const size_t slash = target.rfind('/');
+    if (!target.starts_with("/bot") || slash == 0) {
+        co_return MakeResponse(request, http::status::not_found,
+                               MakeError(http::status::not_found, "Not Found"));
+    }
+    const std::string_view method = target.substr(slash + 1);
+
+    json params = json::object();
+    if (!request.body().empty()) {
+        params = json::parse(request.body(), nullptr, false);
+        if (!params.is_object()) {
+            co_return MakeResponse(
+                request, http::status::bad_request,
+                MakeError(http::status::bad_request, "Bad Request: invalid JSON"));
+        }
+    }
+
+    try {
+        if (method == "getUpdates") {
+            co_return MakeResponse(request, http::status::ok, co_await GetUpdates(params));
+        }
+        if (method == "sendMessage" && TakeRejectedSend()) {
+            const json error = {
+                {"ok", false},
+                {"error_code", 429},
+                {"description", "Too Many Requests: retry after " +
+                                    std::to_string(reject_retry_after_.load())},
+                {"parameters", {{"retry_after", reject_retry_after_.load()}}}};
+            co_return MakeResponse(request, http::status::too_many_requests, error.dump());
+        }
+        if (method == "sendMessage") {
+            co_return MakeResponse(request, http::status::ok, SendMessage(params));
+        }
+    } catch (const json::exception& e) {
+        co_return MakeResponse(request, http::status::bad_request,
+                               MakeError(http::status::bad_request,
+                                         std::format("Bad Request: {}", e.what())));
+    }
+    // deleteWebhook, setWebhook и прочее: бот только проверяет ok
+    co_return MakeResponse(request, http::status::ok, R"({"ok":true,"result":true})");
+}
+
+net::awaitable<std::string> MockApiServer::GetUpdates(const json& params) {
+    ++polls_;
+    const long offset = params.value("offset", 0L);
+    const size_t limit = std::clamp<size_t>(params.value("limit", MAX_UPDATES), 1, MAX_UPDATES);
+    const std::chrono::seconds timeout{params.value("timeout", 0)};
+
+    std::string result = R"({"ok":true,"result":[)";
+    if (TakeUpdates(offset, limit, result) == 0 && timeout.count() > 0) {
+        // Длинный опрос: ждем новое сообщение или истечение таймаута
+        net::steady_timer timer(executor_);
+        timer.expires_after(timeout);
+        while (server_.IsOpen() && TakeUpdates(offset, limit, result) == 0 &&
+               timer.expiry() > net::steady_timer::clock_type::now()) {
+            waiters_.push_back(&timer);
+            boost::system::error_code ec;
+            co_await timer.async_wait(net::redirect_error(use_awaitable, ec));
+            std::erase(waiters_, &timer);
+        }
+    }
+    result += "]}";
+    co_return result;
+}
+
+std::string MockApiServer::SendMessage(const json& params) {
+    const long chat_id = params.at("chat_id").get<long>();
+    const std::string text = params.at("text").get<std::string>();
+    ++sent_;
+    if (send_handler_) {
+        send_handler_(chat_id, text);
+    }
+
+    const json response = {{"ok", true},
+                           {"result",
+                            {{"message_id", next_message_id_++},
+                             {"date", UnixTime()},
+                             {"chat", {{"id", chat_id}, {"type", "private"}}},
+                             {"text", text}}}};
+    return response.dump();
+}
+
+bool MockApiServer::TakeRejectedSend() {
+    size_t left = sends_to_reject_.load();
+    while (left > 0 && !sends_to_reject_.compare_exchange_weak(left, left - 1)) {
+    }
+    if (left == 0) {
+        return false;
+    }
+    ++rejected_;
+    return true;
+}
+
+size_t MockApiServer::TakeUpdates(long offset, size_t limit, std::string& result) {
+    std::lock_guard lock(mutex_);
+    // Смещение подтверждает все обновления до него
+    while (!updates_.empty() && updates_.front().id < offset) {
+        updates_.pop_front();
+    }
+
+    const size_t count = std::min(limit, updates_.size());
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            result += ',';
+        }
+        result += updates_[i].data;
+    }
+    return count;
+}
+
+void MockApiServer::WakeWaiters() {
+    for (net::steady_timer* timer : waiters_) {
+        timer->cancel();
+    }
+}
+
+}  // namespace bench
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "HttpServer.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+struct MockApiOptions {
+    std::string listen_address = "127.0.0.1";
+    // 0 - любой свободный порт
+    unsigned short port = 8081;
+    // Простаивающее keep-alive соединение закрывается. По умолчанию дольше таймаута
+    // длинного опроса, чтобы соединение бота не рвалось между опросами
+    std::chrono::milliseconds idle_timeout{90000};
+    // Искусственная задержка каждого ответа, имитирует медленный API
+    std::chrono::milliseconds latency{0};
+};
+
+// Локальная замена Telegram Bot API для тестов и нагрузочных замеров.
+// Отвечает по обычному HTTP на getUpdates (с длинным опросом) и sendMessage,
+// остальные методы принимает без действий. Токен в пути не проверяется.
+// Сообщения чатов добавляются через PushMessage() и отдаются getUpdates,
+// пока клиент не подтвердит их смещением, как это делает Telegram.
+// Работает на однопоточном исполнителе, переданном в конструктор
+class MockApiServer {
+ public:
+    using json = nlohmann::json;
+    using SendHandler = std::function<void(long chat_id, const std::string& text)>;
+
+    // Значение limit в getUpdates по умолчанию и максимальное
+    static constexpr size_t MAX_UPDATES = 100;
+    static constexpr size_t MAX_BODY_SIZE = 1024 * 1024;
+
+    MockApiServer(boost::asio::any_io_executor executor, MockApiOptions options = {});
+
+    MockApiServer(const MockApiServer&) = delete;
+    MockApiServer& operator=(const MockApiServer&) = delete;
+
+    // Открывает порт. Ошибки бросаются сразу
+    void Listen() { server_.Listen(); }
+    // Цикл приема соединений до вызова Stop()
+    boost::asio::awaitable<void> Run() { return server_.Run(); }
+    // Вызывается на исполнителе сервера
+    void Stop();
+
+    unsigned short GetPort() const { return server_.GetPort(); }
+    // Адрес для BotOptions::api_url
+    std::string GetUrl() const;
+
+    // Ставит текстовое сообщение чата в очередь getUpdates и возвращает его update_id.
+    // Можно вызывать из любого потока
+    long PushMessage(long chat_id, std::string text);
+    // Вызывается на исполнителе сервера для каждого sendMessage. Задается до Run()
+    void SetSendHandler(SendHandler handler) { send_handler_ = std::move(handler); }
+    // Следующие count вызовов sendMessage получат 429 Too Many Requests с retry_after,
+    // как при превышении лимитов Telegram. Можно вызывать из любого потока
+    void RejectSends(size_t count, std::chrono::seconds retry_after);
+
+    uint64_t GetPollCount() const { return polls_; }
+    uint64_t GetSentCount() const { return sent_; }
+    uint64_t GetConnectionCount() const { return server_.GetConnectionCount(); }
+    uint64_t GetRejectedCount() const { return rejected_; }
+
+    // Ответ на один запрос. getUpdates может ждать новые сообщения до своего timeout
+    boost::asio::awaitable<bot::HttpServerResponse> HandleRequest(const bot::HttpRequest& request);
+
+ private:
+    struct PendingUpdate {
+        long id;
+        // Обновление хранится готовым JSON: повторная выдача его не сериализует
+        std::string data;
+    };
+
+    boost::asio::any_io_executor executor_;
+    MockApiOptions options_;
+    bot::HttpServer server_;
+    SendHandler send_handler_;
+
+    std::mutex mutex_;
+    std::deque<PendingUpdate> updates_;
+    long next_update_id_ = 1;
+
+    // Таймеры getUpdates, ждущих новых сообщений. Только на исполнителе сервера
+    std::vector<boost::asio::steady_timer*> waiters_;
+    long next_message_id_ = 1;
+    std::atomic<uint64_t> polls_ = 0;
+    std::atomic<uint64_t> sent_ = 0;
+    std::atomic<size_t> sends_to_reject_ = 0;
+    std::atomic<int64_t> reject_retry_after_ = 0;
+    std::atomic<uint64_t> rejected_ = 0;
+
+    boost::asio::awaitable<std::string> GetUpdates(const json& params);
+    std::string SendMessage(const json& params);
+    // Забирает одно отклонение из RejectSends
+    bool TakeRejectedSend();
+    // Отбрасывает подтвержденные обновления и дописывает в result до limit
+    // остальных. Возвращает число дописанных
+    size_t TakeUpdates(long offset, size_t limit, std::string& result);
+    void WakeWaiters();
+};
+
+}  // namespace bench
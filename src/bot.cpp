@@ -1,17 +1,75 @@
 #include "Bot.hpp"
-#include "Task.hpp"
+#include "Trace.hpp"
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
 
-using namespace task;
 using namespace bot;
 
+namespace {
+
+std::string GetEnv(const char* name, const std::string& fallback = "") {
+    const char* value = std::getenv(name);
+    return value != nullptr ? value : fallback;
+}
+
+// Без TG_BOT_WEBHOOK_URL бот получает обновления длинным опросом
+BotOptions ReadBotOptions() {
+    BotOptions bot_options;
+    bot_options.api_url = GetEnv("TG_BOT_API_URL", bot_options.api_url);
+    bot_options.worker_threads = std::stoul(GetEnv("TG_BOT_WORKERS", "0"));
+    bot_options.storage_dir = GetEnv("TG_BOT_STORAGE_DIR");
+    bot_options.write_behind.max_delay = std::chrono::milliseconds(std::stoul(GetEnv(
+        "TG_BOT_MAX_UNSAVED_MS", std::to_string(bot_options.write_behind.max_delay.count()))));
+
+    // Метрики включаются заданием порта
+    MetricsOptions& metrics = bot_options.metrics;
+    const std::string metrics_port = GetEnv("TG_BOT_METRICS_PORT");
+    metrics.enabled = !metrics_port.empty();
+    if (metrics.enabled) {
+        metrics.port = static_cast<unsigned short>(std::stoul(metrics_port));
+    }
+    metrics.listen_address = GetEnv("TG_BOT_METRICS_ADDRESS", metrics.listen_address);
+
+    WebhookOptions& options = bot_options.webhook;
+    options.public_url = GetEnv("TG_BOT_WEBHOOK_URL");
+    options.listen_address = GetEnv("TG_BOT_WEBHOOK_ADDRESS", options.listen_address);
+    options.port = static_cast<unsigned short>(
+        std::stoul(GetEnv("TG_BOT_WEBHOOK_PORT", std::to_string(options.port))));
+    options.path = GetEnv("TG_BOT_WEBHOOK_PATH", options.path);
+    options.secret_token = GetEnv("TG_BOT_WEBHOOK_SECRET");
+    options.cert_file = GetEnv("TG_BOT_WEBHOOK_CERT");
+    options.key_file = GetEnv("TG_BOT_WEBHOOK_KEY");
+    return bot_options;
+}
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
-    try {
-        TaskManager task_manager;
+    // Аргументы видны всем в списке процессов (ps), переменная окружения - нет
+    std::string token = GetEnv("TG_BOT_TOKEN");
+    if (token.empty() && argc > 1) {
+        token = argv[1];
+        std::cerr << "Warning: the bot token passed as an argument is visible in the process "
+                     "list, set TG_BOT_TOKEN instead"
+                  << std::endl;
+    }
+    if (token.empty()) {
+        std::cerr << "Usage: TG_BOT_TOKEN=<bot_token> tg-bot (or tg-bot <bot_token>)" << std::endl;
+        return 1;
+    }
+
+    // Трасса пишется при выходе и по SIGUSR1
+    const trace::TraceSession trace_session(GetEnv("CHECKLIST_TRACE"));
 
-        Bot bot("8483:fvfv-заглушка");
+    try {
+        BotOptions options = ReadBotOptions();
+        options.trace_file = trace_session.GetPath();
+        Bot bot(token, std::move(options));
         bot.Start();
 
     } catch (const std::exception& e) {
@@ -19,4 +77,4 @@ int main(int argc, char* argv[]) {
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,22 @@
+#include "Backoff.hpp"
+
+#include <algorithm>
+
+namespace bot {
+
+Backoff::Backoff(Duration initial, Duration max)
+    : initial_(initial), max_(std::max(initial, max)), random_(std::random_device{}()) {}
+
+Backoff::Duration Backoff::Next() {
+    Duration delay = initial_;
+    for (size_t i = 0; i < failures_ && delay < max_; ++i) {
+        delay *= 2;
+    }
+    delay = std::min(delay, max_);
+    ++failures_;
+
+    std::uniform_int_distribution<Duration::rep> jitter(delay.count() / 2, delay.count());
+    return Duration(jitter(random_));
+}
+
+}  // namespace bot
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+
+namespace bot {
+
+// Экспоненциальная задержка между повторами с верхней границей и случайным
+// разбросом, чтобы после сбоя клиенты не повторяли запросы одновременно
+class Backoff {
+ public:
+    using Duration = std::chrono::milliseconds;
+
+    static constexpr Duration DEFAULT_INITIAL{250};
+    static constexpr Duration DEFAULT_MAX{30000};
+
+    explicit Backoff(Duration initial = DEFAULT_INITIAL, Duration max = DEFAULT_MAX);
+
+    // Задержка перед следующей попыткой: случайная величина в [d/2, d],
+    // где d удваивается с каждой неудачей и ограничена max
+    Duration Next();
+    void Reset() { failures_ = 0; }
+
+    size_t GetFailures() const { return failures_; }
+
+ private:
+    Duration initial_;
+    Duration max_;
+    size_t failures_ = 0;
+    std::mt19937 random_;
+};
+
+}  // namespace bot
@@ -1,130 +1,542 @@
 #include "Bot.hpp"
 
+#include "Backoff.hpp"
 #include "CommandHandler.hpp"
 #include "Message.hpp"
+#include "UpdateDecoder.hpp"
 #include "Task.hpp"
+#include "Trace.hpp"
 
 #ifdef WIN32
 #include <windows.h>
 #endif
 
-#include <boost/asio/connect.hpp>
-#include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/ssl/error.hpp>
-#include <boost/asio/ssl/stream.hpp>
-#include <boost/beast/core.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <boost/beast/http.hpp>
-#include <boost/beast/ssl.hpp>
-#include <boost/beast/version.hpp>
 
 #include <chrono>
+#include <csignal>
+#include <exception>
+#include <filesystem>
+#include <format>
 #include <iostream>
-#include <sstream>
-#include <thread>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
 namespace bot {
 
-namespace beast = boost::beast;    // from <boost/beast.hpp>
-namespace http = beast::http;      // from <boost/beast/http.hpp>
-namespace net = boost::asio;       // from <boost/asio.hpp>
-namespace ssl = boost::asio::ssl;  // from <boost/asio/ssl.hpp>
-using tcp = net::ip::tcp;          // from <boost/asio/ip/tcp.hpp>
+namespace beast = boost::beast;  // from <boost/beast.hpp>
+namespace http = beast::http;    // from <boost/beast/http.hpp>
+namespace net = boost::asio;     // from <boost/asio.hpp>
+using net::use_awaitable;
 
-Bot::Bot(const std::string& token) : token_(token) {
-    api_url_ = "https://api.telegram.org/bot" + token_;
+namespace {
+
+// Как часто при остановке проверять, остались ли неотправленные ответы
+constexpr std::chrono::milliseconds SHUTDOWN_POLL_INTERVAL{10};
+
+// Завершение отсоединенной корутины: ошибки только логируются
+auto LogErrors(const char* what) {
+    return [what](std::exception_ptr error) {
+        if (!error) {
+            return;
+        }
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            std::cerr << what << ": " << e.what() << std::endl;
+        }
+    };
+}
+
+net::awaitable<void> Sleep(std::chrono::steady_clock::duration duration) {
+    if (duration <= std::chrono::steady_clock::duration::zero()) {
+        co_return;
+    }
+    net::steady_timer timer(co_await net::this_coro::executor);
+    timer.expires_after(duration);
+    co_await timer.async_wait(use_awaitable);
+}
+
+std::filesystem::path ResolveStorageDir(const std::string& storage_dir) {
+    if (!storage_dir.empty()) {
+        return storage_dir;
+    }
+    // Нужен только каталог: сам основной список не загружаем
+    return std::filesystem::path(task::ReadConfig().path) / "chats";
+}
+
+const SendLimits& CheckSendLimits(const SendLimits& limits) {
+    if (!(limits.global_per_second > 0) || !(limits.chat_per_second > 0)) {
+        throw std::invalid_argument(
+            std::format("Send rate limits must be positive: {} per second, {} per chat",
+                        limits.global_per_second, limits.chat_per_second));
+    }
+    return limits;
+}
+
+// Ячейка Bot::Metrics::commands для команды сообщения
+size_t GetCommandIndex(const Message& message) {
+    const parser::CommandInfo* command = parser::FindCommand(message.GetCommand(), parser::BOT);
+    return command != nullptr ? static_cast<size_t>(command->type) : parser::COMMAND_TYPE_COUNT;
+}
+
+ApiError MakeApiError(const Bot::json& response, unsigned status) {
+    std::string description = "Telegram API error";
+    if (response.contains("description") && response["description"].is_string()) {
+        description = response["description"];
+    }
+
+    int error_code = static_cast<int>(status);
+    if (response.contains("error_code") && response["error_code"].is_number_integer()) {
+        error_code = response["error_code"];
+    }
+
+    std::chrono::seconds retry_after{0};
+    if (response.contains("parameters") && response["parameters"].is_object()) {
+        const Bot::json& parameters = response["parameters"];
+        if (parameters.contains("retry_after") && parameters["retry_after"].is_number_integer()) {
+            retry_after = std::chrono::seconds(parameters["retry_after"].get<int>());
+        }
+    }
+
+    return ApiError("Telegram API error: " + description, error_code, retry_after);
+}
+
+}  // namespace
+
+Bot::Bot(const std::string& token, BotOptions options)
+    : token_(token),
+      api_(ApiEndpoint::Parse(options.api_url)),
+      connections_(ioc_.get_executor(), api_),
+      send_limits_(CheckSendLimits(options.send_limits)),
+      global_bucket_(send_limits_.global_per_second, send_limits_.global_per_second),
+      updates_(ioc_.get_executor()),
+      webhook_options_(std::move(options.webhook)),
+      metrics_options_(std::move(options.metrics)),
+      trace_file_(std::move(options.trace_file)),
+      chats_(ResolveStorageDir(options.storage_dir), ChatStore::DEFAULT_SHARDS,
+             ChatStore::DEFAULT_IDLE_TIMEOUT, options.write_behind),
+      command_handler_(chats_),
+      workers_(options.worker_threads) {
+    saved_offset_ = chats_.LoadOffset();
+    RegisterMetrics();
 }
 
 void Bot::Start() {
     std::cout << "Starting Telegram bot...\n";
+    trace::SetThreadName("bot io");
+
+    net::signal_set signals(ioc_, SIGINT, SIGTERM);
+    signals.async_wait([this](const boost::system::error_code& ec, int) {
+        if (!ec) {
+            Stop();
+        }
+    });
+
+    if (metrics_options_.enabled) {
+        StartMetricsServer();
+    }
+#ifndef WIN32
+    if (!trace_file_.empty()) {
+        net::co_spawn(ioc_, DumpTraceOnSignal(), LogErrors("Trace dumping stopped"));
+    }
+#endif
+
+    net::co_spawn(ioc_, ProcessUpdates(), LogErrors("Bot update processing stopped"));
+    net::co_spawn(ioc_, ReceiveUpdates(), LogErrors("Bot update receiving stopped"));
+    net::co_spawn(ioc_, EvictIdleChats(), LogErrors("Chat list eviction stopped"));
+    ioc_.run();
+
+    workers_.Join();
+    const WorkerPool::Stats stats = workers_.GetStats();
+    std::cout << "Commands handled: " << stats.completed << " of " << stats.submitted
+              << ", max queue size: " << stats.max_queued << ", workers: " << stats.threads
+              << std::endl;
+
+    // Изменения, которые еще не успел записать фоновый поток
+    try {
+        chats_.Flush();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save task lists: " << e.what() << std::endl;
+    }
+    std::cout << "Task list writes: " << chats_.GetFlushCount() << std::endl;
+}
+
+void Bot::Stop() {
+    net::post(ioc_, [this] {
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        std::cout << "Stoping Telegram bot..." << std::endl;
+        net::co_spawn(ioc_, Shutdown(), [this](std::exception_ptr error) {
+            LogErrors("Failed to finish sending replies")(error);
+            ioc_.stop();
+        });
+    });
+}
+
+net::awaitable<void> Bot::Shutdown() {
+    // Новые обновления не принимаются: webhook отвечает 503, и Telegram пришлет их
+    // снова после перезапуска, а опрос больше не запрашивает getUpdates.
+    // Уже принятые обновления ProcessUpdates обрабатывает до конца
+    if (webhook_ != nullptr) {
+        webhook_->Stop();
+    }
+
+    // Команды из пула ставят ответы в очередь до CompleteUpdate, поэтому
+    // пустые updates_, in_flight_ и outbox_ значат, что все ответы отправлены
+    const auto deadline = std::chrono::steady_clock::now() + SHUTDOWN_TIMEOUT;
+    while ((updates_.Size() != 0 || !in_flight_.empty() || !outbox_.empty()) &&
+           std::chrono::steady_clock::now() < deadline) {
+        co_await Sleep(SHUTDOWN_POLL_INTERVAL);
+    }
+    if (!in_flight_.empty() || !outbox_.empty()) {
+        std::cerr << "Replies to " << outbox_.size() << " chats, " << in_flight_.size()
+                  << " commands in progress and " << updates_.Size()
+                  << " queued updates are dropped on shutdown" << std::endl;
+    }
+}
 
-    // Создаем TaskManager
-    task::TaskManager task_manager;
+void Bot::RegisterMetrics() {
+    registry_.Add("tg_bot_get_updates_seconds",
+                  "getUpdates round trip time, including the long poll wait",
+                  metrics_.get_updates);
+    registry_.Add("tg_bot_get_updates_errors_total", "Failed getUpdates requests",
+                  metrics_.get_updates_errors);
+    registry_.Add("tg_bot_updates_total", "Updates received by polling or webhook",
+                  metrics_.updates);
+    registry_.Add("tg_bot_connect_seconds", "New API connection time, including the TLS handshake",
+                  connections_.GetConnectTime());
+    registry_.Add("tg_bot_connect_errors_total", "Failed API connection attempts",
+                  connections_.GetConnectErrors());
+
+    const std::string command_help = "Command handling time, including loading the chat list";
+    for (const parser::CommandInfo& command : parser::COMMANDS) {
+        if ((command.scope & parser::BOT) != 0) {
+            registry_.Add("tg_bot_command_seconds", command_help,
+                          metrics_.commands[static_cast<size_t>(command.type)],
+                          std::format("command=\"{}\"", command.name));
+        }
+    }
+    registry_.Add("tg_bot_command_seconds", command_help, metrics_.commands.back(),
+                  "command=\"other\"");
+    registry_.Add("tg_bot_command_seconds", command_help, metrics_.callbacks,
+                  "command=\"button\"");
+
+    registry_.Add("tg_bot_list_write_seconds", "Time to write one chat list file",
+                  chats_.GetWriteTime());
+    registry_.Add("tg_bot_list_write_bytes_total", "Bytes written to chat list files",
+                  chats_.GetBytesWritten());
+    registry_.Add("tg_bot_outbox_messages", "Replies waiting to be sent", metrics_.outbox);
+    registry_.Add("tg_bot_messages_sent_total", "Messages sent", metrics_.sent);
+    registry_.Add("tg_bot_rate_limited_total", "Send attempts answered with 429 Too Many Requests",
+                  metrics_.rate_limited);
+    registry_.Add("tg_bot_send_errors_total", "Replies dropped after a failed send",
+                  metrics_.send_errors);
+}
 
-    // Создаем CommandHandler
-    CommandHandler command_handler(task_manager);
+void Bot::StartMetricsServer() {
+    auto server = std::make_unique<MetricsServer>(ioc_.get_executor(), metrics_options_,
+                                                  [this] { return registry_.Render(); });
+    try {
+        server->Listen();
+    } catch (const std::exception& e) {
+        std::cerr << "Metrics endpoint is unavailable: " << e.what() << std::endl;
+        return;
+    }
 
-    long offset = 0;
+    std::cout << "Metrics are served on port " << server->GetPort() << std::endl;
+    metrics_server_ = std::move(server);
+    net::co_spawn(ioc_, metrics_server_->Run(), LogErrors("Metrics endpoint stopped"));
+}
 
+#ifndef WIN32
+net::awaitable<void> Bot::DumpTraceOnSignal() {
+    // Трасса пишется без остановки бота, сколько угодно раз
+    net::signal_set signals(ioc_, SIGUSR1);
     while (true) {
+        co_await signals.async_wait(use_awaitable);
         try {
-            // Получаем обновления
-            Bot::json updates = GetUpdates(offset);
-
-            // Обрабатываем обновления
-            for (const auto& update : updates["result"]) {
-                if (update.contains("message")) {
-                    Message message(update["message"]);
-                    offset = std::max(offset, static_cast<long>(update["update_id"]) + 1);
-
-                    // Обрабатываем команды
-                    if (message.IsCommand()) {
-                        command_handler.HandleCommand(
-                            message, [this](const std::string& text, long chat_id) {
-                                this->SendMessage(chat_id, text);
-                            });
-                    }
-                }
-            }
+            trace::WriteChromeTraceFile(trace_file_);
+            std::cout << "Trace written to " << trace_file_ << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to write trace: " << e.what() << std::endl;
+        }
+    }
+}
+#endif
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+net::awaitable<void> Bot::ReceiveUpdates() {
+    if (webhook_options_.IsEnabled()) {
+        bool started = false;
+        try {
+            co_await StartWebhook();
+            started = true;
         } catch (const std::exception& e) {
-            std::cerr << "Error in bot loop: " << e.what() << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+            std::cerr << "Webhook is unavailable, falling back to polling: " << e.what()
+                      << std::endl;
+            webhook_.reset();
+        }
+
+        if (started) {
+            co_await webhook_->Run();
+            co_return;
+        }
+
+        // Пока webhook зарегистрирован, getUpdates отвечает ошибкой
+        try {
+            co_await MakeRequest("deleteWebhook", Bot::json::object());
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to delete webhook: " << e.what() << std::endl;
         }
     }
+
+    co_await PollLoop();
 }
 
-void Bot::Stop() { std::cout << "Stoping Telegram bot..." << std::endl; }
+net::awaitable<void> Bot::StartWebhook() {
+    webhook_ = std::make_unique<WebhookServer>(
+        ioc_.get_executor(), webhook_options_,
+        [this](Update update) { updates_.Push(std::move(update)); });
+    webhook_->Listen();
+
+    Bot::json data;
+    data["url"] = webhook_options_.public_url;
+    data["secret_token"] = webhook_->GetOptions().secret_token;
+    co_await MakeRequest("setWebhook", data);
+
+    std::cout << "Webhook is listening on port " << webhook_->GetPort() << std::endl;
+}
 
-Bot::json Bot::MakeRequest(const std::string& method, const Bot::json& data) {
-    std::string host = "api.telegram.org";
-    std::string port = "443";
-    std::string target = "/bot" + token_ + "/" + method;
+net::awaitable<void> Bot::ProcessUpdates() {
+    while (true) {
+        Update update = co_await updates_.Pop();
+        metrics_.updates.Add();
+        last_received_ = std::max(last_received_, update.id);
+        if (update.callback_query.has_value()) {
+            DispatchCallback(std::move(*update.callback_query));
+            continue;
+        }
+        if (!update.message.has_value() || !update.message->IsCommand()) {
+            CompleteUpdate(update.id);
+            continue;
+        }
 
-    net::io_context ioc;
+        // Команда выполняется в пуле потоков, ответы ставятся в очередь отправки
+        const long chat = update.message->GetChatId();
+        const long update_id = update.id;
+        in_flight_.insert(update_id);
+        workers_.Submit(chat, [this, update_id, message = std::move(*update.message)] {
+            try {
+                const ScopedTimer timer(metrics_.commands[GetCommandIndex(message)]);
+                command_handler_.HandleCommand(
+                    message, [this](OutgoingMessage reply) { QueueMessage(std::move(reply)); });
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to handle update " << update_id << ": " << e.what()
+                          << std::endl;
+            }
+            // Обновление завершается и после ошибки команды, иначе смещение больше не сдвинется
+            net::post(ioc_, [this, update_id] { CompleteUpdate(update_id); });
+        });
+    }
+}
 
-    ssl::context ssl_ctx(ssl::context::tlsv12_client);
-    ssl_ctx.set_default_verify_paths();
+void Bot::DispatchCallback(CallbackQuery query) {
+    // Нажатие обрабатывается в очереди своего чата, как команда
+    const long chat = query.chat_id;
+    const long update_id = query.update_id;
+    in_flight_.insert(update_id);
+    workers_.Submit(chat, [this, update_id, query = std::move(query)] {
+        std::string notice;
+        try {
+            const ScopedTimer timer(metrics_.callbacks);
+            notice = command_handler_.HandleCallback(
+                query, [this](OutgoingMessage reply) { QueueMessage(std::move(reply)); });
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to handle update " << update_id << ": " << e.what() << std::endl;
+        }
+        net::post(ioc_, [this, update_id, id = query.id, notice = std::move(notice)]() mutable {
+            CompleteUpdate(update_id);
+            net::co_spawn(ioc_, AnswerCallbackQuery(std::move(id), std::move(notice)),
+                          LogErrors("Failed to answer callback query"));
+        });
+    });
+}
 
-    tcp::resolver resolver(ioc);
-    beast::ssl_stream<beast::tcp_stream> stream(ioc, ssl_ctx);
+void Bot::CompleteUpdate(long update_id) {
+    in_flight_.erase(update_id);
 
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-        beast::error_code ec{static_cast<int>(::ERR_get_error()), net::error::get_ssl_category()};
-        throw beast::system_error{ec};
+    // Все обновления до первого необработанного уже применены
+    const long offset = in_flight_.empty() ? last_received_ + 1 : *in_flight_.begin();
+    if (offset <= saved_offset_) {
+        return;
     }
+    chats_.SetOffset(offset);
+    saved_offset_ = offset;
+}
 
-    const auto results = resolver.resolve(host, port);
-    beast::get_lowest_layer(stream).connect(results);
+net::awaitable<void> Bot::EvictIdleChats() {
+    while (true) {
+        co_await Sleep(EVICT_INTERVAL);
+        chats_.EvictIdle();
+    }
+}
 
-    stream.handshake(ssl::stream_base::client);
+net::awaitable<void> Bot::PollLoop() {
+    // После перезапуска продолжаем с сохраненного смещения. Обновления, которые
+    // придут повторно, списки чатов отбросят по update_id
+    long offset = saved_offset_;
+    Backoff backoff;
+    // Вектор переиспользуется между запросами
+    std::vector<Update> updates;
+
+    // Следующий длинный опрос начинается сразу после ответа: задержка нужна только после ошибки
+    while (!stopping_) {
+        bool failed = false;
+        try {
+            // Получаем обновления
+            updates.clear();
+            co_await GetUpdates(offset, updates);
 
-    http::request<http::string_body> req{http::verb::post, target, 11};
-    req.set(http::field::host, host);
-    req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-    req.set(http::field::content_type, "application/json");
+            // Передаем обновления обработчику
+            for (Update& update : updates) {
+                offset = std::max(offset, update.id + 1);
+                updates_.Push(std::move(update));
+            }
+            backoff.Reset();
+        } catch (const std::exception& e) {
+            std::cerr << "Error in bot loop: " << e.what() << std::endl;
+            metrics_.get_updates_errors.Add();
+            failed = true;
+        }
 
-    req.body() = data.dump();
-    req.prepare_payload();
+        if (failed) {
+            const Backoff::Duration delay = backoff.Next();
+            std::cerr << "Retrying in " << delay.count() << " ms" << std::endl;
+            co_await Sleep(delay);
+        }
+    }
+}
+
+void Bot::QueueMessage(OutgoingMessage message) {
+    net::post(ioc_, [this, message = std::move(message)]() mutable {
+        const long chat_id = message.chat_id;
+        ChatOutbox& outbox = outbox_[chat_id];
+        outbox.queue.push_back(std::move(message));
+        metrics_.outbox.Add(1);
+        // Для чата уже работает отправитель: он заберет сообщение сам
+        if (!outbox.draining) {
+            outbox.draining = true;
+            net::co_spawn(ioc_, DrainChat(chat_id), LogErrors("Failed to drain chat queue"));
+        }
+    });
+}
 
-    http::write(stream, req);
+net::awaitable<void> Bot::DrainChat(long chat_id) {
+    // Очередь удаляет только этот отправитель, поэтому ссылка живет до конца цикла
+    ChatOutbox& outbox = outbox_.at(chat_id);
+    std::deque<OutgoingMessage>& queue = outbox.queue;
+    while (!queue.empty()) {
+        // Сначала ждем лимит чата, затем общий. Пока ждем, ответы копятся
+        // и уходят одним сообщением
+        co_await Sleep(GetChatBucket(chat_id).Reserve());
+        co_await Sleep(global_bucket_.Reserve());
+
+        const size_t queued = queue.size();
+        OutgoingMessage message = TakeCoalescedMessage(queue);
+        metrics_.outbox.Add(-static_cast<int64_t>(queued - queue.size()));
+        co_await SendWithRetry(std::move(message));
+    }
+    outbox_.erase(chat_id);
+    PruneChatBuckets();
+}
 
-    beast::flat_buffer buffer;
-    http::response<http::dynamic_body> res;
-    http::read(stream, buffer, res);
+net::awaitable<void> Bot::SendWithRetry(OutgoingMessage message) {
+    const long chat_id = message.chat_id;
+    for (int attempt = 1;; ++attempt) {
+        std::chrono::seconds retry_after{0};
+        try {
+            co_await SendMessage(message);
+            metrics_.sent.Add();
+        } catch (const ApiError& e) {
+            // Повторное нажатие кнопки: сообщение уже в нужном виде
+            const std::string_view error = e.what();
+            if (message.edit_message_id != 0 &&
+                error.find("message is not modified") != std::string_view::npos) {
+                break;
+            }
+            if (e.GetErrorCode() == static_cast<int>(http::status::too_many_requests)) {
+                metrics_.rate_limited.Add();
+                // Лимит общий для бота: остальные чаты тоже ждут, а не получают 429
+                global_bucket_.Pause(e.GetRetryAfter());
+            }
+            if (attempt < MAX_SEND_ATTEMPTS) {
+                retry_after = e.GetRetryAfter();
+            }
+            if (retry_after.count() == 0) {
+                std::cerr << "Failed to send message to chat " << chat_id << ": " << e.what()
+                          << std::endl;
+                metrics_.send_errors.Add();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to send message to chat " << chat_id << ": " << e.what()
+                      << std::endl;
+            metrics_.send_errors.Add();
+        }
 
-    beast::error_code ec;
-    stream.shutdown(ec);
-    if (ec == net::error::eof) {
-        ec = {};
+        if (retry_after.count() == 0) {
+            break;
+        }
+        std::cerr << "Rate limited in chat " << chat_id << ", retrying in " << retry_after.count()
+                  << " s" << std::endl;
+        co_await Sleep(retry_after);
     }
+}
 
-    std::string response_body = boost::beast::buffers_to_string(res.body().data());
+TokenBucket& Bot::GetChatBucket(long chat_id) {
+    auto [it, inserted] =
+        chat_buckets_.try_emplace(chat_id, send_limits_.chat_per_second, send_limits_.chat_burst);
+    return it->second;
+}
+
+void Bot::PruneChatBuckets() {
+    // Полное ведро ничем не отличается от нового, его можно удалить
+    if (chat_buckets_.size() <= MAX_IDLE_CHAT_BUCKETS) {
+        return;
+    }
+    const TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+    std::erase_if(chat_buckets_, [now](const auto& item) { return item.second.IsFull(now); });
+}
 
-    if (res.result() != http::status::ok) {
+net::awaitable<HttpResponse> Bot::PostRequest(std::string method, Bot::json data,
+                                              ConnectionPool::Duration timeout) {
+    const std::string target = api_.path + "/bot" + token_ + "/" + method;
+    HttpResponse res = co_await connections_.Post(target, data.dump(), timeout);
+    const std::string& response_body = res.body;
+
+    if (res.status != static_cast<unsigned>(http::status::ok)) {
+        // Telegram описывает ошибку в теле, в том числе retry_after для 429
+        const Bot::json error = Bot::json::parse(response_body, nullptr, false);
+        if (error.is_object()) {
+            throw MakeApiError(error, res.status);
+        }
         throw std::runtime_error("HTTP request failed with status: " +
-                                 std::to_string(res.result_int()) + ", body: " + response_body);
+                                 std::to_string(res.status) + ", body: " + response_body);
     }
+    co_return res;
+}
+
+net::awaitable<Bot::json> Bot::MakeRequest(std::string method, Bot::json data,
+                                           ConnectionPool::Duration timeout) {
+    const HttpResponse res = co_await PostRequest(std::move(method), std::move(data), timeout);
+    const std::string& response_body = res.body;
 
     try {
         Bot::json response_json = Bot::json::parse(response_body);
@@ -132,37 +544,69 @@ Bot::json Bot::MakeRequest(const std::string& method, const Bot::json& data) {
         if (response_json.contains("ok") && response_json["ok"].is_boolean()) {
             if (!response_json["ok"]) {
                 // Если "ok" равно false, выбрасываем исключение с сообщением об ошибке
-                std::string error_message = "Telegram API error";
-                if (response_json.contains("description") &&
-                    response_json["description"].is_string()) {
-                    error_message = response_json["description"];
-                }
-                throw std::runtime_error("Telegram API error: " + error_message);
+                throw MakeApiError(response_json, res.status);
             }
         } else {
             throw std::runtime_error(
                 "Invalid Telegram API response: missing or invalid 'ok' field");
         }
 
-        return response_json;
+        co_return response_json;
     } catch (const Bot::json::parse_error& e) {
         throw std::runtime_error("Failed to parse JSON response: " + std::string(e.what()) +
                                  ", body: " + response_body);
     }
 }
 
-Bot::json Bot::GetUpdates(long offset) {
+net::awaitable<void> Bot::GetUpdates(long offset, std::vector<Update>& updates) {
     Bot::json data;
     data["offset"] = offset;
-    data["timeout"] = 30;  // Таймаут в секундах
-    return MakeRequest("getUpdates", data);
+    data["timeout"] = POLL_TIMEOUT;  // Таймаут в секундах
+    // Сервер держит длинный опрос до POLL_TIMEOUT секунд, поэтому ждем ответ дольше
+    trace::AsyncSpan span("bot", "getUpdates");
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const HttpResponse res = co_await PostRequest(
+        "getUpdates", data, std::chrono::seconds(POLL_TIMEOUT) + ConnectionPool::DEFAULT_TIMEOUT);
+    metrics_.get_updates.Observe(std::chrono::steady_clock::now() - start);
+    span.End();
+
+    trace::Span decode_span("bot", "DecodeUpdates");
+
+    // Ответы с ошибкой редки и короткие: их разбираем целиком
+    if (!DecodeUpdates(res.body, updates)) {
+        throw MakeApiError(Bot::json::parse(res.body, nullptr, false), res.status);
+    }
 }
 
-void Bot::SendMessage(long chat_id, const std::string& text) {
+net::awaitable<void> Bot::SendMessage(OutgoingMessage message) {
+    // Длинные ответы заранее делит TakeCoalescedMessage
     Bot::json data;
-    data["chat_id"] = chat_id;
-    data["text"] = text;
-    MakeRequest("sendMessage", data);
+    data["chat_id"] = message.chat_id;
+    data["text"] = std::move(message.text);
+    if (!message.reply_markup.is_null()) {
+        data["reply_markup"] = std::move(message.reply_markup);
+    }
+
+    if (message.edit_message_id != 0) {
+        // editMessageText без reply_markup убирает клавиатуру, поэтому отдельный
+        // editMessageReplyMarkup не нужен: текст и кнопки меняются одним запросом
+        data["message_id"] = message.edit_message_id;
+        trace::AsyncSpan span("bot", "editMessageText");
+        co_await MakeRequest("editMessageText", data);
+    } else {
+        trace::AsyncSpan span("bot", "sendMessage");
+        co_await MakeRequest("sendMessage", data);
+    }
+}
+
+net::awaitable<void> Bot::AnswerCallbackQuery(std::string id, std::string text) {
+    Bot::json data;
+    data["callback_query_id"] = std::move(id);
+    if (!text.empty()) {
+        data["text"] = std::move(text);
+    }
+    trace::AsyncSpan span("bot", "answerCallbackQuery");
+    co_await MakeRequest("answerCallbackQuery", data);
 }
 
 }  // namespace bot
@@ -1,30 +1,199 @@
 #pragma once
 
-#include <boost/beast.hpp>
+#include "ChatStore.hpp"
+#include "CommandHandler.hpp"
+#include "Commands.hpp"
+#include "ConnectionPool.hpp"
+#include "Metrics.hpp"
+#include "MetricsServer.hpp"
+#include "Task.hpp"
+#include "TokenBucket.hpp"
+#include "UpdateQueue.hpp"
+#include "WebhookServer.hpp"
+#include "WorkerPool.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
 #include <nlohmann/json.hpp>
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <set>
+#include <stdexcept>
 #include <string>
-#include <functional>
+#include <unordered_map>
+#include <vector>
 
 namespace bot {
 
+// Ограничения Telegram на отправку: около 30 сообщений в секунду всего
+// и около одного в секунду в один чат
+struct SendLimits {
+    double global_per_second = 30;
+    double chat_per_second = 1;
+    double chat_burst = 3;
+};
+
+struct BotOptions {
+    // Адрес Bot API. http:// - например, для локальной замены API в тестах и замерах
+    std::string api_url = "https://api.telegram.org";
+    WebhookOptions webhook;
+    // Потоки для обработки команд, 0 - по числу ядер
+    size_t worker_threads = 0;
+    SendLimits send_limits;
+    // Каталог со списками задач чатов. Пустой - каталог chats рядом с основным списком
+    std::string storage_dir;
+    // Когда изменения списков записываются на диск
+    WriteBehindOptions write_behind;
+    // HTTP endpoint с метриками для Prometheus
+    MetricsOptions metrics;
+    // Куда писать трассу по SIGUSR1 (кроме Windows). Пустой - сигнал не обрабатывается
+    std::string trace_file;
+};
+
+// Ошибка, которую вернул Telegram API (ok = false)
+class ApiError : public std::runtime_error {
+ public:
+    ApiError(const std::string& message, int error_code, std::chrono::seconds retry_after)
+        : std::runtime_error(message), error_code_(error_code), retry_after_(retry_after) {}
+
+    int GetErrorCode() const { return error_code_; }
+    // Для 429 Too Many Requests - сколько ждать перед повтором, иначе ноль
+    std::chrono::seconds GetRetryAfter() const { return retry_after_; }
+
+ private:
+    int error_code_;
+    std::chrono::seconds retry_after_;
+};
+
+// Бот работает на одном io_context: прием обновлений (длинный опрос или webhook)
+// и отправка ответов выполняются корутинами и не блокируют друг друга.
+// Команды обрабатываются пулом потоков: разные чаты параллельно, один чат по порядку
 class Bot {
  public:
     using json = nlohmann::json;
 
-    Bot(const std::string& token);
+    // Таймаут длинного опроса getUpdates в секундах
+    static constexpr int POLL_TIMEOUT = 30;
+    static constexpr int MAX_SEND_ATTEMPTS = 5;
+    // Сколько ведер отдельных чатов хранить, прежде чем удалять полные
+    static constexpr size_t MAX_IDLE_CHAT_BUCKETS = 1024;
+    // Как часто выгружать списки чатов, к которым давно не обращались
+    static constexpr std::chrono::minutes EVICT_INTERVAL{1};
+    // Сколько при остановке ждать ответов на уже принятые команды
+    static constexpr std::chrono::seconds SHUTDOWN_TIMEOUT{10};
+
+    explicit Bot(const std::string& token, BotOptions options = {});
 
+    // Запускает прием обновлений и блокирует поток до вызова Stop() или сигнала SIGINT/SIGTERM
     void Start();
+    // Перестает принимать обновления, отправляет ответы на уже принятые команды
+    // (не дольше SHUTDOWN_TIMEOUT) и завершает Start(). Можно вызывать из любого потока
     void Stop();
-    
+
+    // Для регистрации команд плагинов до вызова Start()
+    CommandHandler& GetCommandHandler() { return command_handler_; }
+
+    // Метрики в текстовом формате Prometheus, как их отдает /metrics
+    std::string RenderMetrics() const { return registry_.Render(); }
+
  private:
+    // Метрики самого бота. Соединения и запись списков считают ConnectionPool и ChatStore
+    struct Metrics {
+        Histogram get_updates;
+        Counter get_updates_errors;
+        Counter updates;
+        // По типу встроенной команды, последняя ячейка - команды плагинов и неизвестные
+        std::array<Histogram, parser::COMMAND_TYPE_COUNT + 1> commands;
+        // Нажатия кнопок под списком
+        Histogram callbacks;
+        Gauge outbox;
+        Counter sent;
+        Counter rate_limited;
+        Counter send_errors;
+    };
+
     std::string token_;
-    std::string api_url_;
+    ApiEndpoint api_;
+    boost::asio::io_context ioc_;
+    // Соединения с сервером API переиспользуются между запросами
+    ConnectionPool connections_;
+    // Очередь ответов одного чата
+    struct ChatOutbox {
+        std::deque<OutgoingMessage> queue;
+        // Для чата работает DrainChat: только он забирает сообщения и удаляет очередь.
+        // Пустая очередь этого не означает - сообщение может быть еще в отправке
+        bool draining = false;
+    };
+
+    // Очереди ответов по чатам: ответы одному чату уходят по порядку,
+    // а разные чаты отправляются параллельно в пределах SendLimits
+    std::unordered_map<long, ChatOutbox> outbox_;
+    SendLimits send_limits_;
+    TokenBucket global_bucket_;
+    std::unordered_map<long, TokenBucket> chat_buckets_;
+    // Обновления из опроса и webhook обрабатываются одной очередью
+    UpdateQueue updates_;
+    // Обновления, отданные в пул, но еще не обработанные. Сохраняемое смещение
+    // не заходит дальше первого из них, чтобы после сбоя его получить снова
+    std::set<long> in_flight_;
+    long last_received_ = 0;
+    long saved_offset_ = 0;
+    // Остановка началась: новые обновления не запрашиваются
+    bool stopping_ = false;
+    WebhookOptions webhook_options_;
+    std::unique_ptr<WebhookServer> webhook_;
+    Metrics metrics_;
+    MetricsRegistry registry_;
+    MetricsOptions metrics_options_;
+    std::unique_ptr<MetricsServer> metrics_server_;
+    std::string trace_file_;
+
+    ChatStore chats_;
+    CommandHandler command_handler_;
+    // Объявлен последним: потоки останавливаются раньше, чем удаляется то, что они используют
+    WorkerPool workers_;
+
+    void RegisterMetrics();
+    // Ошибка открытия порта только логируется: бот работает и без метрик
+    void StartMetricsServer();
+#ifndef WIN32
+    boost::asio::awaitable<void> DumpTraceOnSignal();
+#endif
+    // Webhook, если он настроен и доступен, иначе длинный опрос
+    boost::asio::awaitable<void> ReceiveUpdates();
+    boost::asio::awaitable<void> StartWebhook();
+    boost::asio::awaitable<void> PollLoop();
+    boost::asio::awaitable<void> ProcessUpdates();
+    // Нажатие кнопки: обработка в пуле, затем ответ на callback_query
+    void DispatchCallback(CallbackQuery query);
+    void CompleteUpdate(long update_id);
+    boost::asio::awaitable<void> EvictIdleChats();
+    // Ждет команд в пуле и очередей отправки перед остановкой io_context
+    boost::asio::awaitable<void> Shutdown();
+    // Запрос с проверкой HTTP статуса. Тело ответа разбирает вызывающий
+    boost::asio::awaitable<HttpResponse> PostRequest(std::string method, json data,
+                                                     ConnectionPool::Duration timeout =
+                                                         ConnectionPool::DEFAULT_TIMEOUT);
+    boost::asio::awaitable<json> MakeRequest(std::string method, json data,
+                                             ConnectionPool::Duration timeout =
+                                                 ConnectionPool::DEFAULT_TIMEOUT);
+    // Дописывает полученные обновления в updates, не строя дерево JSON
+    boost::asio::awaitable<void> GetUpdates(long offset, std::vector<Update>& updates);
+    // sendMessage или, для правки, editMessageText
+    boost::asio::awaitable<void> SendMessage(OutgoingMessage message);
+    // Повторяет отправку после 429, выдерживая retry_after
+    boost::asio::awaitable<void> SendWithRetry(OutgoingMessage message);
+    // Убирает часы ожидания с нажатой кнопки. text - всплывающее уведомление
+    boost::asio::awaitable<void> AnswerCallbackQuery(std::string id, std::string text);
 
-    json MakeRequest(const std::string& method, const json& data);
-    json GetUpdates(long offset);
-    void SendMessage(long chat_id, const std::string& text);
-    
+    void QueueMessage(OutgoingMessage message);
+    boost::asio::awaitable<void> DrainChat(long chat_id);
+    TokenBucket& GetChatBucket(long chat_id);
+    void PruneChatBuckets();
 };
 
 }  // namespace bot
@@ -0,0 +1,212 @@
+#include "ChatStore.hpp"
+
+#include "Trace.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+namespace bot {
+
+namespace {
+
+using json = nlohmann::json;
+
+const std::string OFFSET_FILE = "offset.json";
+
+std::optional<json> ReadJson(const std::filesystem::path& path) {
+    std::ifstream fin(path);
+    if (!fin) {
+        return std::nullopt;
+    }
+    return json::parse(fin);
+}
+
+}  // namespace
+
+ChatStore::Handle::Handle(ChatStore& store, std::shared_ptr<Entry> entry)
+    : store_(&store), entry_(std::move(entry)), lock_(entry_->mutex) {}
+
+void ChatStore::Handle::Commit(long update_id) {
+    entry_->update_id = std::max(update_id, entry_->update_id);
+    entry_->dirty = true;
+    store_->writer_.Notify();
+}
+
+ChatStore::ChatStore(std::filesystem::path dir, size_t shards, Clock::duration idle_timeout,
+                     WriteBehindOptions write_options)
+    : dir_(std::move(dir)),
+      idle_timeout_(idle_timeout),
+      shards_(std::max<size_t>(shards, 1)),
+      writer_([this] { WriteChanges(); }, write_options) {}
+
+ChatStore::Handle ChatStore::Acquire(long chat_id, Clock::time_point now) {
+    std::shared_ptr<Entry> entry;
+    {
+        Shard& shard = GetShard(chat_id);
+        std::lock_guard lock(shard.mutex);
+        std::shared_ptr<Entry>& slot = shard.entries[chat_id];
+        if (slot == nullptr) {
+            slot = std::make_shared<Entry>();
+        }
+        slot->last_used = now;
+        entry = slot;
+    }
+
+    // Файл читается под блокировкой списка, а не шарда: загрузка одного чата
+    // не задерживает остальные
+    Handle handle(*this, std::move(entry));
+    if (!handle.entry_->tasks.has_value()) {
+        LoadList(*handle.entry_, GetListPath(chat_id));
+    }
+    return handle;
+}
+
+size_t ChatStore::EvictIdle(Clock::time_point now) {
+    size_t evicted = 0;
+    for (Shard& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        evicted += std::erase_if(shard.entries, [&](const auto& item) {
+            const std::shared_ptr<Entry>& entry = item.second;
+            // Новые ссылки появляются только под блокировкой шарда,
+            // поэтому единственная ссылка значит, что список никто не держит
+            return entry.use_count() == 1 && !entry->dirty &&
+                   now - entry->last_used > idle_timeout_;
+        });
+    }
+    return evicted;
+}
+
+size_t ChatStore::GetLoadedCount() const {
+    size_t count = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        count += shard.entries.size();
+    }
+    return count;
+}
+
+std::filesystem::path ChatStore::GetListPath(long chat_id) const {
+    return dir_ / (std::to_string(chat_id) + ".json");
+}
+
+long ChatStore::LoadOffset() const {
+    const std::optional<json> data = ReadJson(dir_ / OFFSET_FILE);
+    if (!data.has_value()) {
+        return 0;
+    }
+    return data->value("offset", 0L);
+}
+
+void ChatStore::SetOffset(long offset) {
+    {
+        std::lock_guard lock(offset_mutex_);
+        offset_ = std::max(offset_, offset);
+    }
+    writer_.Notify();
+}
+
+void ChatStore::Flush() { writer_.Flush(); }
+
+void ChatStore::WriteChanges() {
+    trace::Span span("store", "ChatStore::WriteChanges");
+    // Смещение запоминаем до записи списков: изменения всех обновлений до него
+    // уже внесены в списки и будут записаны ниже
+    long offset = 0;
+    {
+        std::lock_guard lock(offset_mutex_);
+        offset = offset_;
+    }
+
+    std::vector<std::pair<long, std::shared_ptr<Entry>>> dirty;
+    for (Shard& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        for (const auto& [chat_id, entry] : shard.entries) {
+            if (entry->dirty) {
+                dirty.emplace_back(chat_id, entry);
+            }
+        }
+    }
+
+    std::vector<std::string> errors;
+    for (const auto& [chat_id, entry] : dirty) {
+        // Под блокировкой только сериализация, файл пишется без нее
+        std::string data;
+        long update_id = 0;
+        long saved_update_id = 0;
+        {
+            std::lock_guard lock(entry->mutex);
+            data = json{{"update_id", entry->update_id}, {"tasks", entry->tasks->ToJson()}}.dump(4);
+            update_id = entry->update_id;
+            saved_update_id = entry->saved_update_id;
+            entry->dirty = false;
+        }
+        try {
+            ScopedTimer timer(write_time_);
+            task::WriteFileAtomically(GetListPath(chat_id).string(), data);
+            timer.Stop();
+            bytes_written_.Add(data.size());
+        } catch (const std::exception& e) {
+            entry->dirty = true;
+            // Обновления после записанного состояния списка придется получить заново
+            offset = std::min(offset, saved_update_id + 1);
+            errors.push_back(e.what());
+            continue;
+        }
+        std::lock_guard lock(entry->mutex);
+        entry->saved_update_id = std::max(entry->saved_update_id, update_id);
+    }
+
+    if (offset > saved_offset_) {
+        try {
+            const json data = {{"offset", offset}};
+            task::WriteFileAtomically((dir_ / OFFSET_FILE).string(), data.dump());
+            saved_offset_ = offset;
+        } catch (const std::exception& e) {
+            errors.push_back(e.what());
+        }
+    }
+
+    if (!errors.empty()) {
+        std::string message;
+        for (const std::string& error : errors) {
+            message += message.empty() ? error : "; " + error;
+        }
+        throw std::runtime_error(std::format("Failed to write {} file(s): {}", errors.size(), message));
+    }
+}
+
+void ChatStore::LoadList(Entry& entry, const std::filesystem::path& path) {
+    trace::Span span("store", "ChatStore::LoadList");
+    const std::string name = path.string();
+    const std::optional<json> data = ReadJson(path);
+    if (!data.has_value()) {
+        entry.tasks.emplace(task::TaskManager::FromJson(json::array(), name));
+        entry.update_id = 0;
+        return;
+    }
+
+    // Файлы без update_id - просто массив задач
+    if (data->is_array()) {
+        entry.tasks.emplace(task::TaskManager::FromJson(*data, name));
+        entry.update_id = 0;
+        return;
+    }
+    if (!data->is_object() || !data->contains("tasks")) {
+        throw std::runtime_error(std::format("Invalid chat list format in {}", name));
+    }
+    entry.tasks.emplace(task::TaskManager::FromJson((*data)["tasks"], name));
+    entry.update_id = data->value("update_id", 0L);
+    entry.saved_update_id = entry.update_id;
+}
+
+ChatStore::Shard& ChatStore::GetShard(long chat_id) {
+    return shards_[std::hash<long>{}(chat_id) % shards_.size()];
+}
+
+}  // namespace bot
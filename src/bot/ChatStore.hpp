@@ -0,0 +1,132 @@
+#pragma once
+
+#include "ListCache.hpp"
+#include "Metrics.hpp"
+#include "Task.hpp"
+#include "WriteBehind.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bot {
+
+// Списки задач чатов: у каждого чата свой файл <dir>/<chat_id>.json.
+// Вместе с задачами в файле хранится update_id последнего примененного
+// обновления: они записываются одной атомарной заменой файла, поэтому
+// повторно полученное после перезапуска обновление можно распознать.
+// Изменения записываются на диск не сразу, а фоновым потоком WriteBehind.
+// Чаты распределены по шардам, блокировка шарда защищает только таблицу и
+// берется ненадолго. Сам список блокируется отдельно, поэтому команды разных
+// чатов не ждут друг друга. Список загружается при первом обращении и
+// выгружается, если к нему долго не обращались
+class ChatStore {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t DEFAULT_SHARDS = 16;
+    static constexpr std::chrono::minutes DEFAULT_IDLE_TIMEOUT{10};
+
+    struct Entry {
+        std::mutex mutex;
+        std::optional<task::TaskManager> tasks;
+        // update_id последнего изменения
+        long update_id = 0;
+        // update_id, с которым список последний раз записан на диск
+        long saved_update_id = 0;
+        // Есть изменения, еще не записанные на диск. Такой список не выгружается
+        std::atomic<bool> dirty = false;
+        Clock::time_point last_used;
+        // Строки для /list. Выгружается вместе со списком
+        ListCache list_cache;
+    };
+
+    // Доступ к списку одного чата. Пока объект жив, список заблокирован
+    // и не может быть выгружен
+    class Handle {
+     public:
+        task::TaskManager& operator*() const { return *entry_->tasks; }
+        task::TaskManager* operator->() const { return &*entry_->tasks; }
+
+        long GetUpdateId() const { return entry_->update_id; }
+        ListCache& GetListCache() const { return entry_->list_cache; }
+        // Отмечает изменение списка и update_id, который к нему привел.
+        // На диск они попадут вместе при ближайшей записи
+        void Commit(long update_id);
+
+     private:
+        friend class ChatStore;
+
+        ChatStore* store_;
+        std::shared_ptr<Entry> entry_;
+        std::unique_lock<std::mutex> lock_;
+
+        Handle(ChatStore& store, std::shared_ptr<Entry> entry);
+    };
+
+    explicit ChatStore(std::filesystem::path dir, size_t shards = DEFAULT_SHARDS,
+                       Clock::duration idle_timeout = DEFAULT_IDLE_TIMEOUT,
+                       WriteBehindOptions write_options = {});
+
+    ChatStore(const ChatStore&) = delete;
+    ChatStore& operator=(const ChatStore&) = delete;
+
+    // Ошибки чтения файла бросаются из Acquire, список при этом не кэшируется
+    Handle Acquire(long chat_id, Clock::time_point now = Clock::now());
+
+    // Выгружает сохраненные списки, которые не используются и простаивают дольше idle_timeout.
+    // Возвращает число выгруженных списков
+    size_t EvictIdle(Clock::time_point now = Clock::now());
+
+    size_t GetLoadedCount() const;
+    std::filesystem::path GetListPath(long chat_id) const;
+
+    // Смещение getUpdates, с которого продолжать после перезапуска. 0 - файла нет
+    long LoadOffset() const;
+    // Смещение записывается после списков: к этому моменту все обновления
+    // до него уже сохранены в списках
+    void SetOffset(long offset);
+
+    // Немедленно записывает все изменения, например при остановке бота
+    void Flush();
+    uint64_t GetFlushCount() const { return writer_.GetFlushCount(); }
+    // Запись отдельных файлов списков: время и объем
+    const Histogram& GetWriteTime() const { return write_time_; }
+    const Counter& GetBytesWritten() const { return bytes_written_; }
+
+ private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<long, std::shared_ptr<Entry>> entries;
+    };
+
+    std::filesystem::path dir_;
+    Clock::duration idle_timeout_;
+    std::vector<Shard> shards_;
+
+    std::mutex offset_mutex_;
+    long offset_ = 0;
+    long saved_offset_ = 0;
+
+    Histogram write_time_;
+    Counter bytes_written_;
+
+    // Объявлен последним: при удалении записывает оставшиеся изменения,
+    // пока списки еще существуют
+    WriteBehind writer_;
+
+    Shard& GetShard(long chat_id);
+    // Записывает измененные списки, затем смещение. Ошибка одного списка не мешает
+    // записать остальные, все ошибки бросаются вместе в конце. Вызывается из writer_
+    void WriteChanges();
+    static void LoadList(Entry& entry, const std::filesystem::path& path);
+};
+
+}  // namespace bot
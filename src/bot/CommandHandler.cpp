@@ -1,194 +1,426 @@
 #include "CommandHandler.hpp"
 
-#include <iostream>
-#include <sstream>
+#include "Parser.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace bot {
 
-CommandHandler::CommandHandler(task::TaskManager& task_manager) : task_manager_(task_manager) {}
-
-void CommandHandler::HandleCommand(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
-    std::string command = message.GetCommand();
-    
-    if (command == "start") {
-        HandleStart(message, send_message_callback);
-    } else if (command == "help") {
-        HandleHelp(message, send_message_callback);
-    } else if (command == "add") {
-        HandleAdd(message, send_message_callback);
-    } else if (command == "list") {
-        HandleList(message, send_message_callback);
-    } else if (command == "done") {
-        HandleDone(message, send_message_callback);
-    } else if (command == "remove") {
-        HandleRemove(message, send_message_callback);
-    } else if (command == "clear") {
-        HandleClear(message, send_message_callback);
-    } else {
-        // Неизвестная команда
-        std::string response = "Неизвестная команда. Используйте /help для получения списка доступных команд.";
-        send_message_callback(response, message.GetChatId());
-    }
-}
-
-void CommandHandler::HandleStart(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
+namespace {
+
+// Действие кнопки под списком. Данные кнопки: "list:<страница>" или
+// "done:<страница>:<номер задачи>"
+struct ListAction {
+    size_t page = 1;
+    std::optional<size_t> toggle;
+    // Версия задачи (Task::revision) на момент отправки кнопки
+    uint64_t revision = 0;
+};
+
+template <typename Number>
+bool ParseNumber(std::string_view text, Number& value) {
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc{} && end == text.data() + text.size();
+}
+
+std::optional<ListAction> ParseCallbackData(std::string_view data) {
+    ListAction action;
+    if (data.starts_with("list:")) {
+        if (!ParseNumber(data.substr(5), action.page)) {
+            return std::nullopt;
+        }
+        return action;
+    }
+    if (data.starts_with("done:")) {
+        // done:<страница>:<номер задачи>:<версия задачи>
+        data.remove_prefix(5);
+        const size_t first = data.find(':');
+        const size_t second = data.find(':', first == std::string_view::npos ? first : first + 1);
+        size_t index = 0;
+        if (second == std::string_view::npos || !ParseNumber(data.substr(0, first), action.page) ||
+            !ParseNumber(data.substr(first + 1, second - first - 1), index) ||
+            !ParseNumber(data.substr(second + 1), action.revision)) {
+            return std::nullopt;
+        }
+        action.toggle = index;
+        return action;
+    }
+    return std::nullopt;
+}
+
+CommandHandler::json MakeButton(std::string text, std::string data) {
+    return {{"text", std::move(text)}, {"callback_data", std::move(data)}};
+}
+
+}  // namespace
+
+const std::array<CommandHandler::Route, parser::COMMAND_TYPE_COUNT> CommandHandler::ROUTES = [] {
+    using parser::TypeCommand;
+    
+    std::array<Route, parser::COMMAND_TYPE_COUNT> routes{};
+    auto add = [&routes](TypeCommand type, Route route) {
+        routes[static_cast<size_t>(type)] = route;
+    };
+    // /start и /help не читают список задач и не загружают его
+    add(TypeCommand::START, {&CommandHandler::HandleStart, nullptr});
+    add(TypeCommand::HELP, {&CommandHandler::HandleHelp, nullptr});
+    add(TypeCommand::ADD, {nullptr, &CommandHandler::HandleAdd});
+    add(TypeCommand::LIST, {nullptr, &CommandHandler::HandleList});
+    add(TypeCommand::DONE, {nullptr, &CommandHandler::HandleDone});
+    add(TypeCommand::REMOVE, {nullptr, &CommandHandler::HandleRemove});
+    add(TypeCommand::CLEAR, {nullptr, &CommandHandler::HandleClear});
+    return routes;
+}();
+
+CommandHandler::CommandHandler(ChatStore& chats) : chats_(chats) {}
+
+void CommandHandler::HandleCommand(const Message& message, Reply reply) {
+    if (const parser::CommandInfo* command = parser::FindCommand(message.GetCommand(), parser::BOT)) {
+        const Route& route = ROUTES[static_cast<size_t>(command->type)];
+        // Имена команд - литералы из таблицы парсера
+        trace::Span span("command", command->name.data());
+        if (route.simple != nullptr) {
+            (this->*route.simple)(message, reply);
+            return;
+        }
+        if (route.with_list != nullptr) {
+            WithList(message.GetChatId(), message.GetUpdateId(), reply,
+                     [&](ChatStore::Handle& list) {
+                         (this->*route.with_list)(message, list, reply);
+                     });
+            return;
+        }
+    }
+    
+    if (const Plugin* plugin = FindPlugin(message.GetCommand())) {
+        trace::Span span("command", "plugin");
+        WithList(message.GetChatId(), message.GetUpdateId(), reply,
+                 [&](ChatStore::Handle& list) { plugin->handler(message, list, reply); });
+        return;
+    }
+    
+    // Неизвестная команда
+    reply("Неизвестная команда. Используйте /help для получения списка доступных команд.", message.GetChatId());
+}
+
+std::string CommandHandler::HandleCallback(const CallbackQuery& query, Reply reply) {
+    trace::Span span("command", "callback");
+    const std::optional<ListAction> action = ParseCallbackData(query.data);
+    if (!action.has_value()) {
+        return "Кнопка устарела.";
+    }
+
+    std::string notice;
+    WithList(query.chat_id, query.update_id, reply, [&](ChatStore::Handle& list) {
+        if (const std::optional<size_t> index = action->toggle) {
+            // Список могли изменить после отправки сообщения: под тем же номером
+            // теперь другая задача или ее нет. Тогда только обновляем сообщение
+            const std::vector<task::Task>& items = list->GetTasks();
+            if (*index < items.size() && items[*index].revision == action->revision) {
+                list->ToggleTasks(std::span(&*index, 1));
+                list.Commit(query.update_id);
+            } else {
+                notice = "Список изменился, сообщение обновлено.";
+            }
+        }
+
+        OutgoingMessage message = RenderList(list, action->page, query.chat_id);
+        message.edit_message_id = query.message_id;
+        reply(std::move(message));
+    });
+    return notice;
+}
+
+void CommandHandler::RegisterCommand(std::string_view name, std::string description, PluginHandler handler) {
+    std::string key(name);
+    std::transform(key.begin(), key.end(), key.begin(), parser::ToLowerAscii);
+    
+    if (key.empty() || parser::FindCommand(key, parser::BOT) != nullptr || plugins_.contains(key)) {
+        throw std::invalid_argument("Command name is empty or already taken: " + key);
+    }
+    
+    plugin_names_.push_back(key);
+    plugins_.emplace(std::move(key), Plugin{std::move(description), std::move(handler)});
+}
+
+void CommandHandler::WithList(long chat_id, long update_id, Reply reply,
+                              FunctionRef<void(ChatStore::Handle&)> handler) {
+    std::optional<ChatStore::Handle> list;
+    try {
+        list.emplace(chats_.Acquire(chat_id));
+    } catch (const std::exception& e) {
+        reply("Ошибка при загрузке списка задач: " + std::string(e.what()), chat_id);
+        return;
+    }
+    
+    // Обновление уже применено до перезапуска: Telegram прислал его повторно
+    if (update_id != 0 && update_id <= list->GetUpdateId()) {
+        return;
+    }
+    
+    handler(*list);
+}
+
+const CommandHandler::Plugin* CommandHandler::FindPlugin(std::string_view name) const {
+    if (plugins_.empty()) {
+        return nullptr;
+    }
+    std::string key(name);
+    std::transform(key.begin(), key.end(), key.begin(), parser::ToLowerAscii);
+    const auto it = plugins_.find(key);
+    return it != plugins_.end() ? &it->second : nullptr;
+}
+
+void CommandHandler::HandleStart(const Message& message, Reply reply) {
     std::string response = "Добро пожаловать в Todo List бот!\n"
                           "Я помогу вам управлять вашими задачами.\n"
                           "Используйте /help для получения списка доступных команд.";
-    send_message_callback(response, message.GetChatId());
+    reply(response, message.GetChatId());
 }
 
-void CommandHandler::HandleHelp(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
+void CommandHandler::HandleHelp(const Message& message, Reply reply) {
     std::string response = "Доступные команды:\n"
                           "/start - Начать работу с ботом\n"
                           "/help - Показать это сообщение\n"
                           "/add <текст задачи> - Добавить новую задачу\n"
-                          "/list - Показать все задачи\n"
-                          "/done <номер задачи> - Отметить задачу как выполненную/невыполненную\n"
-                          "/remove <номер задачи> - Удалить задачу\n"
+                          "/list [страница] - Показать задачи (по 50 на странице)\n"
+                          "/done <номера задач> - Отметить задачи как выполненные/невыполненные, например /done 1-5,9\n"
+                          "/remove <номера задач> - Удалить задачи, например /remove 3 9 40-60\n"
                           "/clear - Очистить все задачи";
-    send_message_callback(response, message.GetChatId());
+    for (const std::string& name : plugin_names_) {
+        response += "\n/" + name + " - " + plugins_.at(name).description;
+    }
+    reply(response, message.GetChatId());
 }
 
-void CommandHandler::HandleAdd(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
-    std::string task_text = ExtractCommandArgument(message.GetText(), "add");
+void CommandHandler::HandleAdd(const Message& message, ChatStore::Handle& list, Reply reply) {
+    std::string task_text = ExtractCommandArgument(message.GetText());
     
     if (task_text.empty()) {
-        send_message_callback("Пожалуйста, укажите текст задачи. Пример: /add Купить молоко", message.GetChatId());
+        reply("Пожалуйста, укажите текст задачи. Пример: /add Купить молоко", message.GetChatId());
         return;
     }
     
     if (task_text.length() > 1000) {
-        send_message_callback("Текст задачи слишком длинный (максимум 1000 символов)", message.GetChatId());
+        reply("Текст задачи слишком длинный (максимум 1000 символов)", message.GetChatId());
         return;
     }
     
     try {
-        task_manager_.AddTask(task_text);
-        task_manager_.Save();
-        send_message_callback("Задача добавлена успешно!", message.GetChatId());
+        list->AddTask(task_text);
+        list.Commit(message.GetUpdateId());
+        reply("Задача добавлена успешно!", message.GetChatId());
     } catch (const std::exception& e) {
-        send_message_callback("Ошибка при добавлении задачи: " + std::string(e.what()), message.GetChatId());
+        reply("Ошибка при добавлении задачи: " + std::string(e.what()), message.GetChatId());
     }
 }
 
-void CommandHandler::HandleList(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
+void CommandHandler::HandleList(const Message& message, ChatStore::Handle& list, Reply reply) {
+    std::string page_str = ExtractCommandArgument(message.GetText());
+    
     try {
-        std::string task_list = GetTaskListString();
-        if (task_list.empty()) {
-            send_message_callback("Список задач пуст.", message.GetChatId());
-        } else {
-            send_message_callback(task_list, message.GetChatId());
+        size_t page = 1;
+        if (!page_str.empty()) {
+            if (page_str.find_first_not_of("0123456789") != std::string::npos) {
+                reply("Неверный формат номера страницы. Пожалуйста, укажите число.", message.GetChatId());
+                return;
+            }
+            page = std::stoull(page_str);
+        }
+        
+        const size_t total = list->CountTasks();
+        const size_t pages = (total + LIST_PAGE_SIZE - 1) / LIST_PAGE_SIZE;
+        if (total != 0 && (page == 0 || page > pages)) {
+            reply("Страница " + std::to_string(page) + " не существует. Всего страниц: " + std::to_string(pages) + ".", message.GetChatId());
+            return;
         }
+        
+        reply(RenderList(list, page, message.GetChatId()));
     } catch (const std::exception& e) {
-        send_message_callback("Ошибка при получении списка задач: " + std::string(e.what()), message.GetChatId());
+        reply("Ошибка при получении списка задач: " + std::string(e.what()), message.GetChatId());
     }
 }
 
-void CommandHandler::HandleDone(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
-    std::string index_str = ExtractCommandArgument(message.GetText(), "done");
+void CommandHandler::HandleDone(const Message& message, ChatStore::Handle& list, Reply reply) {
+    std::string index_str = ExtractCommandArgument(message.GetText());
     
     if (index_str.empty()) {
-        send_message_callback("Пожалуйста, укажите номер задачи. Пример: /done 0", message.GetChatId());
+        reply("Пожалуйста, укажите номер задачи. Пример: /done 0", message.GetChatId());
         return;
     }
     
     try {
-        if (index_str.find_first_not_of("0123456789") != std::string::npos) {
-            send_message_callback("Неверный формат номера задачи. Пожалуйста, укажите число.", message.GetChatId());
-            return;
-        }
-        
-        size_t index = std::stoull(index_str);
+        const std::vector<size_t> indices = ExtractTaskIndices(index_str);
         
-        if (!task_manager_.TaskExists(index)) {
-            send_message_callback("Задача с номером " + std::to_string(index) + " не существует.", message.GetChatId());
+        if (const auto missing = FindMissingTask(*list, indices)) {
+            reply("Задача с номером " + std::to_string(*missing) + " не существует.", message.GetChatId());
             return;
         }
         
-        task_manager_.ToggleTask(index);
-        task_manager_.Save();
-        send_message_callback("Статус задачи обновлен.", message.GetChatId());
+        list->ToggleTasks(indices);
+        list.Commit(message.GetUpdateId());
+        if (indices.size() == 1) {
+            reply("Статус задачи обновлен.", message.GetChatId());
+        } else {
+            reply("Обновлен статус задач: " + std::to_string(indices.size()) + ".", message.GetChatId());
+        }
     } catch (const std::invalid_argument&) {
-        send_message_callback("Неверный формат номера задачи. Пожалуйста, укажите число.", message.GetChatId());
+        reply("Неверный формат номеров задач. Пример: /done 1-5,9", message.GetChatId());
     } catch (const std::exception& e) {
-        send_message_callback("Ошибка при обновлении статуса задачи: " + std::string(e.what()), message.GetChatId());
+        reply("Ошибка при обновлении статуса задачи: " + std::string(e.what()), message.GetChatId());
     }
 }
 
-void CommandHandler::HandleRemove(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
-    std::string index_str = ExtractCommandArgument(message.GetText(), "remove");
+void CommandHandler::HandleRemove(const Message& message, ChatStore::Handle& list, Reply reply) {
+    std::string index_str = ExtractCommandArgument(message.GetText());
     
     if (index_str.empty()) {
-        send_message_callback("Пожалуйста, укажите номер задачи. Пример: /remove 0", message.GetChatId());
+        reply("Пожалуйста, укажите номер задачи. Пример: /remove 0", message.GetChatId());
         return;
     }
     
     try {
-        if (index_str.find_first_not_of("0123456789") != std::string::npos) {
-            send_message_callback("Неверный формат номера задачи. Пожалуйста, укажите число.", message.GetChatId());
-            return;
-        }
-        
-        size_t index = std::stoull(index_str);
+        const std::vector<size_t> indices = ExtractTaskIndices(index_str);
         
-        if (!task_manager_.TaskExists(index)) {
-            send_message_callback("Задача с номером " + std::to_string(index) + " не существует.", message.GetChatId());
+        if (const auto missing = FindMissingTask(*list, indices)) {
+            reply("Задача с номером " + std::to_string(*missing) + " не существует.", message.GetChatId());
             return;
         }
         
-        task_manager_.RemoveTask(index);
-        task_manager_.Save();
-        send_message_callback("Задача удалена.", message.GetChatId());
+        list->RemoveTasks(indices);
+        list.Commit(message.GetUpdateId());
+        if (indices.size() == 1) {
+            reply("Задача удалена.", message.GetChatId());
+        } else {
+            reply("Удалено задач: " + std::to_string(indices.size()) + ".", message.GetChatId());
+        }
     } catch (const std::invalid_argument&) {
-        send_message_callback("Неверный формат номера задачи. Пожалуйста, укажите число.", message.GetChatId());
+        reply("Неверный формат номеров задач. Пример: /remove 3 9 40-60", message.GetChatId());
     } catch (const std::exception& e) {
-        send_message_callback("Ошибка при удалении задачи: " + std::string(e.what()), message.GetChatId());
+        reply("Ошибка при удалении задачи: " + std::string(e.what()), message.GetChatId());
     }
 }
 
-void CommandHandler::HandleClear(const Message& message, std::function<void(const std::string&, long)> send_message_callback) {
+void CommandHandler::HandleClear(const Message& message, ChatStore::Handle& list, Reply reply) {
     try {
-        task_manager_.ClearTasks();
-        task_manager_.Save();
-        send_message_callback("Все задачи удалены.", message.GetChatId());
+        list->ClearTasks();
+        list.Commit(message.GetUpdateId());
+        reply("Все задачи удалены.", message.GetChatId());
     } catch (const std::exception& e) {
-        send_message_callback("Ошибка при очистке задач: " + std::string(e.what()), message.GetChatId());
+        reply("Ошибка при очистке задач: " + std::string(e.what()), message.GetChatId());
     }
 }
 
-std::string CommandHandler::GetTaskListString() const {
-    const auto& tasks = task_manager_.GetTasks();
+std::string CommandHandler::GetTaskListString(ChatStore::Handle& list, size_t page) const {
+    const size_t total = list->CountTasks();
     
-    if (tasks.empty()) {
+    if (total == 0) {
         return "";
     }
     
-    std::ostringstream oss;
-    oss << "Список задач:\n";
+    // Выводим только задачи запрошенной страницы. Пока список не меняется,
+    // строки берутся из кэша без форматирования
+    static constexpr std::string_view HEADER = "Список задач:\n";
+    const size_t pages = (total + LIST_PAGE_SIZE - 1) / LIST_PAGE_SIZE;
+    const std::string_view lines =
+        list.GetListCache().GetLines(*list, (page - 1) * LIST_PAGE_SIZE, LIST_PAGE_SIZE);
     
-    for (size_t i = 0; i < tasks.size(); ++i) {
-        oss << i << ". ";
-        if (tasks[i].done) {
-            oss << "[x] ";
-        } else {
-            oss << "[ ] ";
-        }
-        oss << tasks[i].text << "\n";
+    std::string text;
+    text.reserve(HEADER.size() + lines.size() + 96);
+    text += HEADER;
+    text += lines;
+    if (pages > 1) {
+        std::format_to(std::back_inserter(text),
+                       "Страница {} из {} (всего задач: {}). Следующая: /list {}\n", page, pages,
+                       total, page % pages + 1);
     }
     
-    return oss.str();
+    return text;
+}
+
+OutgoingMessage CommandHandler::RenderList(ChatStore::Handle& list, size_t page,
+                                           long chat_id) const {
+    const task::TaskManager& tasks = *list;
+    const size_t total = tasks.CountTasks();
+    if (total == 0) {
+        return {chat_id, "Список задач пуст."};
+    }
+    const size_t pages = (total + LIST_PAGE_SIZE - 1) / LIST_PAGE_SIZE;
+    page = std::clamp<size_t>(page, 1, pages);
+
+    // Кнопка задачи показывает ее отметку и номер, как строка списка
+    json keyboard = json::array();
+    json row = json::array();
+    const std::vector<task::Task>& items = tasks.GetTasks();
+    const size_t end = std::min(page * LIST_PAGE_SIZE, total);
+    for (size_t i = (page - 1) * LIST_PAGE_SIZE; i < end; ++i) {
+        row.push_back(MakeButton(std::format("[{}] {}", items[i].done ? 'x' : ' ', i),
+                                 std::format("done:{}:{}:{}", page, i, items[i].revision)));
+        if (row.size() == KEYBOARD_ROW_SIZE) {
+            keyboard.push_back(std::move(row));
+            row = json::array();
+        }
+    }
+    if (!row.empty()) {
+        keyboard.push_back(std::move(row));
+    }
+
+    if (pages > 1) {
+        json navigation = json::array();
+        if (page > 1) {
+            navigation.push_back(
+                MakeButton(std::format("« {}", page - 1), std::format("list:{}", page - 1)));
+        }
+        if (page < pages) {
+            navigation.push_back(
+                MakeButton(std::format("{} »", page + 1), std::format("list:{}", page + 1)));
+        }
+        keyboard.push_back(std::move(navigation));
+    }
+
+    return {chat_id, GetTaskListString(list, page), {{"inline_keyboard", std::move(keyboard)}}};
 }
 
-std::string CommandHandler::ExtractCommandArgument(const std::string& text, const std::string& command) const {
-    std::string prefix = "/" + command + " ";
-    size_t pos = text.find(prefix);
+std::string CommandHandler::ExtractCommandArgument(const std::string& text) const {
+    // Аргумент - все, что идет после первого пробела за командой
+    size_t pos = text.find(' ');
     
     if (pos != std::string::npos) {
-        return text.substr(pos + prefix.length());
+        return text.substr(pos + 1);
     }
     
     return "";
 }
 
+std::vector<size_t> CommandHandler::ExtractTaskIndices(const std::string& text) const {
+    std::vector<std::string_view> words;
+    parser::SplitWords(text, words);
+
+    std::vector<size_t> indices;
+    parser::ParseIndices(words, indices);
+    return indices;
+}
+
+std::optional<size_t> CommandHandler::FindMissingTask(const task::TaskManager& tasks,
+                                                     const std::vector<size_t>& indices) const {
+    // Номера отсортированы: достаточно найти первый несуществующий
+    const size_t count = tasks.GetTasks().size();
+    const auto missing = std::lower_bound(indices.begin(), indices.end(), count);
+    if (missing == indices.end()) {
+        return std::nullopt;
+    }
+    return *missing;
+}
+
 }  // namespace bot
\ No newline at end of file
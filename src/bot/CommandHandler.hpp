@@ -1,37 +1,100 @@
 #pragma once
 
+#include "ChatStore.hpp"
+#include "Commands.hpp"
+#include "FunctionRef.hpp"
 #include "Message.hpp"
+#include "Reply.hpp"
 #include "Task.hpp"
 
 #include <nlohmann/json.hpp>
+#include <array>
 #include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace bot {
 
+// Встроенные команды описаны статической таблицей: тип команды из parser::COMMANDS
+// отображается на метод-обработчик, поэтому выбор обработчика - одно обращение
+// по индексу. Плагины добавляют свои команды через RegisterCommand
 class CommandHandler {
  public:
     using json = nlohmann::json;
+    // Отправка ответа в чат. Ссылка не владеет функцией и действует только на время вызова
+    using Reply = bot::Reply;
+    // Обработчик команды плагина. Получает заблокированный список задач чата,
+    // изменения сохраняются вызовом list.Commit(message.GetUpdateId())
+    using PluginHandler = std::function<void(const Message&, ChatStore::Handle&, Reply)>;
+
+    static constexpr size_t LIST_PAGE_SIZE = 50;
+    // Кнопок задач в одном ряду клавиатуры под списком
+    static constexpr size_t KEYBOARD_ROW_SIZE = 5;
+    
+    CommandHandler(ChatStore& chats);
     
-    CommandHandler(task::TaskManager& task_manager);
+    // Можно вызывать из нескольких потоков: у каждого чата свой список,
+    // команды одного чата сериализуются блокировкой его списка
+    void HandleCommand(const Message& message, Reply reply);
+    // Кнопка под списком: переключает задачу или страницу и правит сообщение со списком.
+    // Возвращает короткое уведомление для answerCallbackQuery, пустое - без уведомления
+    std::string HandleCallback(const CallbackQuery& query, Reply reply);
     
-    void HandleCommand(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
+    // Регистрирует команду плагина. Имя без '/' и без учета регистра, встроенные
+    // команды переопределить нельзя. Вызывается до начала обработки команд.
+    // Бросает std::invalid_argument для пустого или уже занятого имени
+    void RegisterCommand(std::string_view name, std::string description, PluginHandler handler);
     
  private:
-    task::TaskManager& task_manager_;
+    using SimpleHandler = void (CommandHandler::*)(const Message&, Reply);
+    using ListHandler = void (CommandHandler::*)(const Message&, ChatStore::Handle&, Reply);
+    
+    // Обработчик встроенной команды: без списка задач или со списком чата
+    struct Route {
+        SimpleHandler simple = nullptr;
+        ListHandler with_list = nullptr;
+    };
+    
+    struct Plugin {
+        std::string description;
+        PluginHandler handler;
+    };
+    
+    static const std::array<Route, parser::COMMAND_TYPE_COUNT> ROUTES;
+    
+    ChatStore& chats_;
+    std::unordered_map<std::string, Plugin> plugins_;
+    // Порядок регистрации, для /help
+    std::vector<std::string> plugin_names_;
+    
+    // Загружает список чата и вызывает обработчик, если обновление еще не применялось
+    void WithList(long chat_id, long update_id, Reply reply,
+                  FunctionRef<void(ChatStore::Handle&)> handler);
+    const Plugin* FindPlugin(std::string_view name) const;
     
     // Обработчики команд
-    void HandleStart(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    void HandleHelp(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    void HandleAdd(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    void HandleList(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    void HandleDone(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    void HandleRemove(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    void HandleClear(const Message& message, std::function<void(const std::string&, long)> send_message_callback);
-    
-    std::string GetTaskListString() const;
-    std::string ExtractCommandArgument(const std::string& text, const std::string& command) const;
+    void HandleStart(const Message& message, Reply reply);
+    void HandleHelp(const Message& message, Reply reply);
+    void HandleAdd(const Message& message, ChatStore::Handle& list, Reply reply);
+    void HandleList(const Message& message, ChatStore::Handle& list, Reply reply);
+    void HandleDone(const Message& message, ChatStore::Handle& list, Reply reply);
+    void HandleRemove(const Message& message, ChatStore::Handle& list, Reply reply);
+    void HandleClear(const Message& message, ChatStore::Handle& list, Reply reply);
+    
+    // Текст страницы собирается из строк ListCache списка
+    std::string GetTaskListString(ChatStore::Handle& list, size_t page = 1) const;
+    // Страница списка с клавиатурой: кнопка на каждую задачу и переход по страницам.
+    // Несуществующая страница заменяется ближайшей
+    OutgoingMessage RenderList(ChatStore::Handle& list, size_t page, long chat_id) const;
+    std::string ExtractCommandArgument(const std::string& text) const;
+    // Номера задач из аргумента команды: "3", "1-5,9", "3 9 40-60"
+    std::vector<size_t> ExtractTaskIndices(const std::string& text) const;
+    // Первый номер, которого нет в списке, или nullopt, если все существуют
+    std::optional<size_t> FindMissingTask(const task::TaskManager& tasks,
+                                          const std::vector<size_t>& indices) const;
 };
 
 }  // namespace bot
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "ConnectionPool.hpp"
+
+#include "Trace.hpp"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/ssl/error.hpp>
+#include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/version.hpp>
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace bot {
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+using net::use_awaitable;
+
+namespace {
+
+// Сервер не получил запрос целиком или закрыл соединение, не начав ответ:
+// повторить запрос безопасно
+class RequestNotSent : public beast::system_error {
+ public:
+    using beast::system_error::system_error;
+};
+
+bool IsConnectionClosed(const beast::error_code& ec) {
+    return ec == http::error::end_of_stream || ec == net::error::eof ||
+           ec == net::error::connection_reset || ec == ssl::error::stream_truncated;
+}
+
+}  // namespace
+
+class ConnectionPool::Connection {
+ public:
+    Connection(const net::any_io_executor& executor, ssl::context& ssl_ctx, bool use_tls)
+        : stream_(executor, ssl_ctx), use_tls_(use_tls) {}
+
+    ~Connection() { Close(); }
+
+    net::awaitable<void> Connect(const tcp::resolver::results_type& endpoints,
+                                 const std::string& host, SSL_SESSION* session, Duration timeout) {
+        if (use_tls_) {
+            if (!SSL_set_tlsext_host_name(stream_.native_handle(), host.c_str())) {
+                beast::error_code ec{static_cast<int>(::ERR_get_error()),
+                                     net::error::get_ssl_category()};
+                throw beast::system_error{ec};
+            }
+            // Возобновление сессии экономит полное рукопожатие
+            if (session != nullptr) {
+                SSL_set_session(stream_.native_handle(), session);
+            }
+        }
+
+        beast::tcp_stream& layer = beast::get_lowest_layer(stream_);
+        trace::AsyncSpan connect_span("net", "connect");
+        layer.expires_after(timeout);
+        co_await layer.async_connect(endpoints, use_awaitable);
+        layer.socket().set_option(tcp::no_delay(true));
+        connect_span.End();
+
+        if (use_tls_) {
+            trace::AsyncSpan handshake_span("net", "handshake");
+            layer.expires_after(timeout);
+            co_await stream_.async_handshake(ssl::stream_base::client, use_awaitable);
+        }
+        layer.expires_never();
+        last_used_ = Clock::now();
+    }
+
+    net::awaitable<http::response<http::string_body>> Send(
+        const http::request<http::string_body>& request, Duration timeout) {
+        beast::tcp_stream& layer = beast::get_lowest_layer(stream_);
+        http::response<http::string_body> response;
+        beast::error_code ec;
+        layer.expires_after(timeout);
+        trace::AsyncSpan write_span("net", "write");
+        if (use_tls_) {
+            co_await http::async_write(stream_, request, net::redirect_error(use_awaitable, ec));
+        } else {
+            co_await http::async_write(layer, request, net::redirect_error(use_awaitable, ec));
+        }
+        write_span.End();
+        if (ec) {
+            throw RequestNotSent(ec);
+        }
+
+        // Чтение включает ожидание ответа сервера, у getUpdates это весь длинный опрос
+        trace::AsyncSpan read_span("net", "read");
+        layer.expires_after(timeout);
+        size_t received = 0;
+        if (use_tls_) {
+            received = co_await http::async_read(stream_, buffer_, response,
+                                                 net::redirect_error(use_awaitable, ec));
+        } else {
+            received = co_await http::async_read(layer, buffer_, response,
+                                                 net::redirect_error(use_awaitable, ec));
+        }
+        read_span.End();
+        if (ec) {
+            if (IsConnectionClosed(ec) && received == 0 && buffer_.size() == 0) {
+                throw RequestNotSent(ec);
+            }
+            throw beast::system_error(ec);
+        }
+        layer.expires_never();
+
+        ++requests_;
+        last_used_ = Clock::now();
+        co_return response;
+    }
+
+    SSL* GetNativeHandle() { return stream_.native_handle(); }
+    bool UsesTls() const { return use_tls_; }
+
+    bool IsReused() const { return requests_ > 0; }
+
+    bool IsExpired(Clock::time_point now, Duration idle_timeout) const {
+        return now - last_used_ > idle_timeout;
+    }
+
+ private:
+    // Без TLS запросы идут напрямую через нижний tcp_stream
+    beast::ssl_stream<beast::tcp_stream> stream_;
+    bool use_tls_;
+    beast::flat_buffer buffer_;
+    size_t requests_ = 0;
+    Clock::time_point last_used_;
+
+    void Close() {
+        beast::error_code ec;
+        if (use_tls_) {
+            // Тихое закрытие: не ждем close_notify от сервера, а сессия остается пригодной
+            // для возобновления
+            SSL_set_quiet_shutdown(stream_.native_handle(), 1);
+            stream_.shutdown(ec);
+        }
+        beast::get_lowest_layer(stream_).socket().close(ec);
+    }
+};
+
+ApiEndpoint ApiEndpoint::Parse(std::string_view url) {
+    static constexpr std::string_view HTTPS = "https://";
+    static constexpr std::string_view HTTP = "http://";
+
+    ApiEndpoint endpoint;
+    std::string_view rest = url;
+    if (rest.starts_with(HTTPS)) {
+        rest.remove_prefix(HTTPS.size());
+        endpoint.port = "443";
+    } else if (rest.starts_with(HTTP)) {
+        rest.remove_prefix(HTTP.size());
+        endpoint.use_tls = false;
+        endpoint.port = "80";
+    } else {
+        throw std::invalid_argument(std::format("Unsupported API URL scheme: {}", url));
+    }
+
+    const size_t slash = rest.find('/');
+    std::string_view authority = rest.substr(0, slash);
+    if (slash != std::string_view::npos) {
+        std::string_view path = rest.substr(slash);
+        while (path.ends_with('/')) {
+            path.remove_suffix(1);
+        }
+        endpoint.path = path;
+    }
+
+    // Двоеточие внутри [] - часть IPv6 адреса, а не порт
+    const size_t colon = authority.rfind(':');
+    if (colon != std::string_view::npos && authority.find(']', colon) == std::string_view::npos) {
+        const std::string_view port = authority.substr(colon + 1);
+        const bool digits = std::ranges::all_of(port, [](char c) { return c >= '0' && c <= '9'; });
+        if (port.empty() || !digits) {
+            throw std::invalid_argument(std::format("Invalid port in API URL: {}", url));
+        }
+        endpoint.port = port;
+        authority = authority.substr(0, colon);
+    }
+    if (authority.size() >= 2 && authority.front() == '[' && authority.back() == ']') {
+        authority = authority.substr(1, authority.size() - 2);
+    }
+    if (authority.empty()) {
+        throw std::invalid_argument(std::format("API URL without host: {}", url));
+    }
+    endpoint.host = authority;
+    return endpoint;
+}
+
+ConnectionPool::ConnectionPool(net::any_io_executor executor, ApiEndpoint endpoint,
+                               size_t max_idle, Duration idle_timeout)
+    : executor_(std::move(executor)),
+      endpoint_(std::move(endpoint)),
+      max_idle_(max_idle),
+      idle_timeout_(idle_timeout),
+      dns_(executor_, endpoint_.host, endpoint_.port),
+      ssl_ctx_(ssl::context::tls_client) {
+    // Не ниже TLS 1.2, верхнюю границу не ограничиваем, чтобы работали TLS 1.3 и его билеты
+    SSL_CTX_set_min_proto_version(ssl_ctx_.native_handle(), TLS1_2_VERSION);
+    ssl_ctx_.set_default_verify_paths();
+    SSL_CTX_set_session_cache_mode(ssl_ctx_.native_handle(), SSL_SESS_CACHE_CLIENT);
+}
+
+ConnectionPool::~ConnectionPool() = default;
+
+net::awaitable<HttpResponse> ConnectionPool::Post(std::string target, std::string body,
+                                                  Duration timeout, std::string content_type) {
+    http::request<http::string_body> request{http::verb::post, target, 11};
+    request.set(http::field::host, endpoint_.host);
+    request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    request.set(http::field::content_type, content_type);
+    request.keep_alive(true);
+    request.body() = std::move(body);
+    request.prepare_payload();
+
+    for (int attempt = 0;; ++attempt) {
+        std::unique_ptr<Connection> connection = co_await Acquire(timeout);
+        const bool reused = connection->IsReused();
+        try {
+            http::response<http::string_body> response =
+                co_await connection->Send(request, timeout);
+            StoreSession(*connection);
+
+            HttpResponse result{response.result_int(), std::move(response.body())};
+            if (response.keep_alive()) {
+                Release(std::move(connection));
+            }
+            co_return result;
+        } catch (const RequestNotSent&) {
+            // Сервер мог закрыть простаивающее соединение: повторяем один раз на новом
+            if (!reused || attempt > 0) {
+                throw;
+            }
+        }
+    }
+}
+
+size_t ConnectionPool::GetIdleCount() const {
+    std::lock_guard lock(mutex_);
+    return idle_.size();
+}
+
+net::awaitable<std::unique_ptr<ConnectionPool::Connection>> ConnectionPool::Acquire(
+    Duration timeout) {
+    SessionPtr session;
+    {
+        std::lock_guard lock(mutex_);
+        const Clock::time_point now = Clock::now();
+        while (!idle_.empty()) {
+            std::unique_ptr<Connection> connection = std::move(idle_.back());
+            idle_.pop_back();
+            if (!connection->IsExpired(now, idle_timeout_)) {
+                co_return connection;
+            }
+        }
+        if (session_ != nullptr) {
+            SSL_SESSION_up_ref(session_.get());
+            session.reset(session_.get());
+        }
+    }
+
+    trace::AsyncSpan resolve_span("net", "resolve");
+    const DnsCache::Endpoints endpoints = co_await dns_.Resolve();
+    resolve_span.End();
+
+    auto connection = std::make_unique<Connection>(executor_, ssl_ctx_, endpoint_.use_tls);
+    try {
+        const Clock::time_point start = Clock::now();
+        co_await connection->Connect(endpoints, endpoint_.host, session.get(), timeout);
+        connect_time_.Observe(Clock::now() - start);
+    } catch (const beast::system_error&) {
+        connect_errors_.Add();
+        // Адреса могли смениться: следующее подключение обновит их в фоне
+        dns_.Invalidate();
+        throw;
+    }
+    co_return connection;
+}
+
+void ConnectionPool::Release(std::unique_ptr<Connection> connection) {
+    std::lock_guard lock(mutex_);
+    if (idle_.size() < max_idle_) {
+        idle_.push_back(std::move(connection));
+    }
+}
+
+void ConnectionPool::StoreSession(Connection& connection) {
+    if (!connection.UsesTls()) {
+        return;
+    }
+    // В TLS 1.3 билет сессии приходит после рукопожатия, поэтому берем сессию
+    // после первого ответа
+    SSL_SESSION* session = SSL_get1_session(connection.GetNativeHandle());
+    if (session == nullptr) {
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    session_.reset(session);
+}
+
+}  // namespace bot
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "DnsCache.hpp"
+#include "Metrics.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <openssl/ssl.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bot {
+
+// Адрес API сервера из URL вида http[s]://host[:port][/path]
+struct ApiEndpoint {
+    bool use_tls = true;
+    std::string host;
+    std::string port;
+    // Префикс пути запросов без завершающего '/', обычно пустой
+    std::string path;
+
+    // Бросает std::invalid_argument для схемы, отличной от http и https, или URL без хоста
+    static ApiEndpoint Parse(std::string_view url);
+};
+
+struct HttpResponse {
+    unsigned status = 0;
+    std::string body;
+};
+
+// Пул долгоживущих HTTP/1.1 keep-alive соединений к одному хосту, обычно поверх TLS.
+// Соединение берется из пула на время запроса и возвращается обратно, если
+// сервер не закрыл его. Новые соединения возобновляют последнюю TLS сессию,
+// поэтому полное рукопожатие выполняется только для первого соединения.
+// Без TLS (http://) пул нужен для локальной замены API в тестах и замерах.
+// Адреса хоста берутся из DnsCache и не запрашиваются на каждое соединение.
+// Все операции асинхронные и выполняются на исполнителе пула
+class ConnectionPool {
+ public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    static constexpr size_t DEFAULT_MAX_IDLE = 4;
+    // Простаивающие дольше соединения сервер, скорее всего, уже закрыл
+    static constexpr std::chrono::seconds DEFAULT_IDLE_TIMEOUT{50};
+    static constexpr std::chrono::seconds DEFAULT_TIMEOUT{30};
+
+    ConnectionPool(boost::asio::any_io_executor executor, ApiEndpoint endpoint,
+                   size_t max_idle = DEFAULT_MAX_IDLE, Duration idle_timeout = DEFAULT_IDLE_TIMEOUT);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // timeout ограничивает каждую сетевую операцию: подключение, отправку и чтение ответа.
+    // На соединении из пула запрос повторяется один раз, только если сервер его точно
+    // не получил: отправка не удалась или соединение закрылось до начала ответа.
+    // После таймаута ответа запрос не повторяется, иначе сообщение могло бы уйти дважды
+    boost::asio::awaitable<HttpResponse> Post(std::string target, std::string body,
+                                              Duration timeout = DEFAULT_TIMEOUT,
+                                              std::string content_type = "application/json");
+
+    const std::string& GetHost() const { return endpoint_.host; }
+    size_t GetIdleCount() const;
+    const DnsCache& GetDnsCache() const { return dns_; }
+    // Время установки новых соединений вместе с TLS рукопожатием
+    const Histogram& GetConnectTime() const { return connect_time_; }
+    const Counter& GetConnectErrors() const { return connect_errors_; }
+
+ private:
+    class Connection;
+
+    struct SessionDeleter {
+        void operator()(SSL_SESSION* session) const { SSL_SESSION_free(session); }
+    };
+    using SessionPtr = std::unique_ptr<SSL_SESSION, SessionDeleter>;
+
+    boost::asio::any_io_executor executor_;
+    ApiEndpoint endpoint_;
+    size_t max_idle_;
+    Duration idle_timeout_;
+
+    DnsCache dns_;
+    boost::asio::ssl::context ssl_ctx_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Connection>> idle_;
+    SessionPtr session_;
+
+    Histogram connect_time_;
+    Counter connect_errors_;
+
+    boost::asio::awaitable<std::unique_ptr<Connection>> Acquire(Duration timeout);
+    void Release(std::unique_ptr<Connection> connection);
+    void StoreSession(Connection& connection);
+};
+
+}  // namespace bot
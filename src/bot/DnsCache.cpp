@@ -0,0 +1,87 @@
+#include "DnsCache.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <exception>
+#include <iostream>
+#include <utility>
+
+namespace bot {
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+using net::use_awaitable;
+
+DnsCache::DnsCache(net::any_io_executor executor, std::string host, std::string port,
+                   Clock::duration ttl)
+    : executor_(std::move(executor)), host_(std::move(host)), port_(std::move(port)), ttl_(ttl) {}
+
+net::awaitable<DnsCache::Endpoints> DnsCache::Resolve() {
+    Endpoints endpoints;
+    bool refresh = false;
+    {
+        std::lock_guard lock(mutex_);
+        endpoints = endpoints_;
+        if (!endpoints.empty() && Clock::now() >= expires_ && !refreshing_) {
+            refreshing_ = true;
+            refresh = true;
+        }
+    }
+
+    if (refresh) {
+        net::co_spawn(executor_, Refresh(), net::detached);
+    }
+    if (!endpoints.empty()) {
+        co_return endpoints;
+    }
+    co_return co_await Lookup();
+}
+
+void DnsCache::Invalidate() {
+    std::lock_guard lock(mutex_);
+    expires_ = Clock::time_point{};
+}
+
+bool DnsCache::HasAddresses() const {
+    std::lock_guard lock(mutex_);
+    return !endpoints_.empty();
+}
+
+size_t DnsCache::GetLookupCount() const {
+    std::lock_guard lock(mutex_);
+    return lookups_;
+}
+
+net::awaitable<DnsCache::Endpoints> DnsCache::Lookup() {
+    tcp::resolver resolver(executor_);
+    Endpoints endpoints = co_await resolver.async_resolve(host_, port_, use_awaitable);
+
+    std::lock_guard lock(mutex_);
+    ++lookups_;
+    if (!endpoints.empty()) {
+        endpoints_ = endpoints;
+        expires_ = Clock::now() + ttl_;
+    }
+    co_return endpoints;
+}
+
+net::awaitable<void> DnsCache::Refresh() {
+    bool failed = false;
+    try {
+        co_await Lookup();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to refresh addresses of " << host_ << ", using last known: "
+                  << e.what() << std::endl;
+        failed = true;
+    }
+
+    std::lock_guard lock(mutex_);
+    refreshing_ = false;
+    if (failed) {
+        expires_ = Clock::now() + FAILURE_RETRY;
+    }
+}
+
+}  // namespace bot
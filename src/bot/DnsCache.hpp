@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace bot {
+
+// Кэш адресов одного хоста. Устаревшие адреса отдаются сразу, а обновляются
+// в фоне, поэтому DNS запрос не задерживает отправку сообщений. Если обновить
+// адреса не удалось, продолжаем использовать последние известные.
+// Asio не сообщает TTL записей, поэтому срок жизни фиксированный
+class DnsCache {
+ public:
+    using Clock = std::chrono::steady_clock;
+    using Endpoints = boost::asio::ip::tcp::resolver::results_type;
+
+    static constexpr std::chrono::minutes DEFAULT_TTL{5};
+    // Пауза перед повторной попыткой после неудачного обновления
+    static constexpr std::chrono::seconds FAILURE_RETRY{30};
+
+    DnsCache(boost::asio::any_io_executor executor, std::string host, std::string port,
+             Clock::duration ttl = DEFAULT_TTL);
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    // Ждет DNS только при первом обращении, когда адресов еще нет
+    boost::asio::awaitable<Endpoints> Resolve();
+    // Помечает адреса устаревшими, например после ошибки подключения.
+    // Они остаются запасным вариантом до успешного обновления
+    void Invalidate();
+
+    bool HasAddresses() const;
+    size_t GetLookupCount() const;
+
+ private:
+    boost::asio::any_io_executor executor_;
+    std::string host_;
+    std::string port_;
+    Clock::duration ttl_;
+
+    mutable std::mutex mutex_;
+    Endpoints endpoints_;
+    Clock::time_point expires_;
+    bool refreshing_ = false;
+    size_t lookups_ = 0;
+
+    boost::asio::awaitable<Endpoints> Lookup();
+    boost::asio::awaitable<void> Refresh();
+};
+
+}  // namespace bot
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace bot {
+
+template <typename Signature>
+class FunctionRef;
+
+// Невладеющая ссылка на вызываемый объект: два указателя, без копирования
+// объекта и выделения памяти. Объект должен жить дольше ссылки, поэтому
+// FunctionRef передают параметром и не сохраняют
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+ public:
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> &&
+                 std::is_invocable_r_v<R, F&, Args...>)
+    FunctionRef(F&& function) noexcept
+        : object_(const_cast<void*>(static_cast<const void*>(std::addressof(function)))),
+          call_([](void* object, Args... args) -> R {
+              using Target = std::remove_reference_t<F>;
+              return std::invoke(*static_cast<Target*>(object), std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return call_(object_, std::forward<Args>(args)...); }
+
+ private:
+    void* object_;
+    R (*call_)(void*, Args...);
+};
+
+}  // namespace bot
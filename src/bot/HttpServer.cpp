@@ -0,0 +1,133 @@
+#include "HttpServer.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/version.hpp>
+
+#include <utility>
+
+namespace bot {
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = net::ip::tcp;
+using net::use_awaitable;
+
+HttpServerResponse MakeHttpResponse(const HttpRequest& request, http::status status,
+                                    std::string body, std::string_view content_type) {
+    HttpServerResponse response{status, request.version()};
+    response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.set(http::field::content_type, content_type);
+    response.keep_alive(request.keep_alive());
+    response.body() = std::move(body);
+    response.prepare_payload();
+    return response;
+}
+
+HttpServer::HttpServer(net::any_io_executor executor, HttpServerOptions options,
+                       Handler handler)
+    : executor_(std::move(executor)),
+      options_(std::move(options)),
+      handler_(std::move(handler)),
+      acceptor_(executor_) {}
+
+HttpServer::~HttpServer() = default;
+
+void HttpServer::Listen() {
+    if (!options_.cert_file.empty()) {
+        ssl_ctx_ = std::make_unique<ssl::context>(ssl::context::tls_server);
+        ssl_ctx_->use_certificate_chain_file(options_.cert_file);
+        ssl_ctx_->use_private_key_file(options_.key_file, ssl::context::pem);
+    }
+
+    const tcp::endpoint endpoint(net::ip::make_address(options_.listen_address), options_.port);
+    acceptor_.open(endpoint.protocol());
+    acceptor_.set_option(net::socket_base::reuse_address(true));
+    acceptor_.bind(endpoint);
+    acceptor_.listen(net::socket_base::max_listen_connections);
+}
+
+net::awaitable<void> HttpServer::Run() {
+    while (acceptor_.is_open()) {
+        boost::system::error_code ec;
+        tcp::socket socket = co_await acceptor_.async_accept(
+            net::redirect_error(use_awaitable, ec));
+        if (ec == net::error::operation_aborted) {
+            break;
+        }
+        if (ec) {
+            continue;
+        }
+        ++connections_;
+        // Ошибки отдельного соединения не должны останавливать сервер
+        net::co_spawn(executor_, Serve(std::move(socket)), net::detached);
+    }
+}
+
+void HttpServer::Stop() {
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+}
+
+unsigned short HttpServer::GetPort() const { return acceptor_.local_endpoint().port(); }
+
+template <typename Stream>
+net::awaitable<void> HttpServer::ServeRequests(Stream& stream) {
+    beast::flat_buffer buffer;
+    while (true) {
+        http::request_parser<http::string_body> parser;
+        parser.header_limit(static_cast<std::uint32_t>(options_.header_limit));
+        parser.body_limit(options_.body_limit);
+
+        beast::get_lowest_layer(stream).expires_after(options_.idle_timeout);
+        boost::system::error_code ec;
+        co_await http::async_read(stream, buffer, parser, net::redirect_error(use_awaitable, ec));
+        if (ec == http::error::end_of_stream) {
+            break;
+        }
+        if (ec) {
+            throw boost::system::system_error(ec);
+        }
+
+        // Пока обработчик ждет (например, длинный опрос), таймаут не должен оборвать соединение
+        beast::get_lowest_layer(stream).expires_never();
+        const HttpRequest request = parser.release();
+        HttpServerResponse response = co_await handler_(request);
+        const bool keep_alive = response.keep_alive();
+        beast::get_lowest_layer(stream).expires_after(options_.idle_timeout);
+        co_await http::async_write(stream, response, use_awaitable);
+
+        if (!keep_alive) {
+            break;
+        }
+    }
+
+    boost::system::error_code ec;
+    beast::get_lowest_layer(stream).socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+net::awaitable<void> HttpServer::Serve(tcp::socket socket) {
+    beast::tcp_stream stream(std::move(socket));
+    try {
+        if (ssl_ctx_ == nullptr) {
+            co_await ServeRequests(stream);
+        } else {
+            beast::ssl_stream<beast::tcp_stream> tls_stream(std::move(stream), *ssl_ctx_);
+            beast::get_lowest_layer(tls_stream).expires_after(options_.idle_timeout);
+            co_await tls_stream.async_handshake(ssl::stream_base::server, use_awaitable);
+            co_await ServeRequests(tls_stream);
+        }
+    } catch (const boost::system::system_error&) {
+        // Клиент отключился или не уложился в таймаут
+    }
+}
+
+}  // namespace bot
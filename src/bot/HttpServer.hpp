@@ -0,0 +1,81 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/status.hpp>
+#include <boost/beast/http/string_body.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace bot {
+
+using HttpRequest = boost::beast::http::request<boost::beast::http::string_body>;
+using HttpServerResponse = boost::beast::http::response<boost::beast::http::string_body>;
+
+// Ответ на request с тем же keep-alive и версией HTTP
+HttpServerResponse MakeHttpResponse(const HttpRequest& request,
+                                    boost::beast::http::status status, std::string body,
+                                    std::string_view content_type);
+
+struct HttpServerOptions {
+    std::string listen_address = "127.0.0.1";
+    // 0 - любой свободный порт
+    unsigned short port = 0;
+    // Сколько ждать следующего запроса на открытом соединении
+    std::chrono::milliseconds idle_timeout{30000};
+    size_t header_limit = 8 * 1024;
+    size_t body_limit = 1024 * 1024;
+    // Сертификат и ключ для HTTPS. Без них сервер принимает обычный HTTP
+    std::string cert_file;
+    std::string key_file;
+};
+
+// Встроенный HTTP(S) сервер с keep-alive: принимает соединения и отдает каждый
+// запрос обработчику. Обработчик - корутина, поэтому может ждать, не блокируя
+// остальные соединения. Работает на исполнителе, переданном в конструктор
+class HttpServer {
+ public:
+    using Handler = std::function<boost::asio::awaitable<HttpServerResponse>(const HttpRequest&)>;
+
+    HttpServer(boost::asio::any_io_executor executor, HttpServerOptions options,
+               Handler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // Открывает порт. Ошибки (занятый порт, неверный сертификат) бросаются сразу
+    void Listen();
+    // Цикл приема соединений до вызова Stop()
+    boost::asio::awaitable<void> Run();
+    // Вызывается на исполнителе сервера
+    void Stop();
+
+    unsigned short GetPort() const;
+    bool IsOpen() const { return acceptor_.is_open(); }
+    uint64_t GetConnectionCount() const { return connections_; }
+
+ private:
+    boost::asio::any_io_executor executor_;
+    HttpServerOptions options_;
+    Handler handler_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::unique_ptr<boost::asio::ssl::context> ssl_ctx_;
+    std::atomic<uint64_t> connections_ = 0;
+
+    boost::asio::awaitable<void> Serve(boost::asio::ip::tcp::socket socket);
+    template <typename Stream>
+    boost::asio::awaitable<void> ServeRequests(Stream& stream);
+};
+
+}  // namespace bot
@@ -0,0 +1,60 @@
+#include "ListCache.hpp"
+
+#include <algorithm>
+
+namespace bot {
+
+std::string_view ListCache::GetLines(const task::TaskManager& tasks, size_t from, size_t count) {
+    if (!valid_ || version_ != tasks.GetVersion()) {
+        Update(tasks);
+    }
+
+    const size_t lines = revisions_.size();
+    from = std::min(from, lines);
+    const size_t to = from + std::min(count, lines - from);
+    return std::string_view(lines_).substr(offsets_[from], offsets_[to] - offsets_[from]);
+}
+
+void ListCache::Update(const task::TaskManager& tasks) {
+    const std::vector<task::Task>& items = tasks.GetTasks();
+
+    // Строки до первой измененной задачи остаются на месте
+    size_t first = 0;
+    const size_t common = std::min(items.size(), revisions_.size());
+    while (first < common && revisions_[first] == items[first].revision) {
+        ++first;
+    }
+
+    // Хвост собирается заново. Строка, чья задача осталась под тем же номером
+    // и не менялась, копируется из старого буфера. Номер версии задачи
+    // уникален, а при удалении задачи сдвигаются только к началу, поэтому
+    // совпадение версии значит, что строка та же
+    const size_t base = offsets_[first];
+    const size_t old_lines = revisions_.size();
+    std::string tail;
+    size_t old_begin = base;
+    offsets_.resize(std::max(offsets_.size(), items.size() + 1));
+    for (size_t i = first; i < items.size(); ++i) {
+        const size_t old_end = i < old_lines ? offsets_[i + 1] : old_begin;
+        if (i < old_lines && revisions_[i] == items[i].revision) {
+            tail.append(lines_, old_begin, old_end - old_begin);
+        } else {
+            task::AppendTaskLine(tail, i, items[i]);
+            ++rendered_;
+        }
+        offsets_[i + 1] = base + tail.size();
+        old_begin = old_end;
+    }
+
+    lines_.resize(base);
+    lines_ += tail;
+    offsets_.resize(items.size() + 1);
+    revisions_.resize(items.size());
+    for (size_t i = first; i < items.size(); ++i) {
+        revisions_[i] = items[i].revision;
+    }
+    version_ = tasks.GetVersion();
+    valid_ = true;
+}
+
+}  // namespace bot
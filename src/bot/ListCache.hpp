@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Task.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bot {
+
+// Отрисованные строки списка задач для /list. Строки лежат подряд в одном буфере,
+// начало каждой хранится отдельно, поэтому страница - просто часть буфера.
+// Пока версия списка не менялась, страница отдается без обхода задач. После
+// изменения заново форматируются только задачи, которые изменились или сдвинулись
+// после удаления, остальные строки копируются как есть.
+// Кэш привязан к одному списку и не потокобезопасен: ChatStore держит его рядом
+// с задачами под той же блокировкой
+class ListCache {
+ public:
+    // Строки задач [from, from + count) в формате task::AppendTaskLine.
+    // Действительны до следующего вызова
+    std::string_view GetLines(const task::TaskManager& tasks, size_t from, size_t count);
+
+    // Сколько строк отформатировано за все время
+    uint64_t GetRenderedCount() const { return rendered_; }
+
+ private:
+    bool valid_ = false;
+    uint64_t version_ = 0;
+    // Строка i - lines_[offsets_[i], offsets_[i + 1])
+    std::string lines_;
+    std::vector<size_t> offsets_{0};
+    // Версия задачи, из которой отрисована строка
+    std::vector<uint64_t> revisions_;
+    uint64_t rendered_ = 0;
+
+    void Update(const task::TaskManager& tasks);
+};
+
+}  // namespace bot
@@ -1,7 +1,8 @@
 #include "Message.hpp"
 
-#include <iostream>
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 namespace bot {
 
@@ -33,21 +34,117 @@ Message::Message(const json& data) {
     }
 }
 
+Message::Message(long id, long chat_id, std::string text)
+    : id_(id), chat_id_(chat_id), text_(std::move(text)) {
+    is_command_ = !text_.empty() && text_[0] == '/';
+}
+
 bool Message::IsCommand() const {
     return is_command_;
 }
 
-std::string Message::GetCommand() const {
+std::string_view Message::GetCommand() const {
     if (!is_command_) {
         return "";
     }
     
-    size_t space_pos = text_.find(' ');
-    if (space_pos != std::string::npos) {
-        return text_.substr(1, space_pos - 1);  // Убираем '/' в начале
+    const std::string_view text = text_;
+    size_t space_pos = text.find(' ');
+    if (space_pos != std::string_view::npos) {
+        return text.substr(1, space_pos - 1);  // Убираем '/' в начале
     } else {
-        return text_.substr(1);  // Убираем '/' в начале
+        return text.substr(1);  // Убираем '/' в начале
+    }
+}
+
+std::vector<std::string_view> SplitMessageText(std::string_view text, size_t max_length) {
+    std::vector<std::string_view> chunks;
+
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t units = 0;
+        size_t pos = start;
+        size_t line_end = std::string_view::npos;
+
+        while (pos < text.size()) {
+            const unsigned char lead = static_cast<unsigned char>(text[pos]);
+            const size_t bytes = lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+            // Символы вне BMP занимают две UTF-16 единицы
+            const size_t width = bytes == 4 ? 2 : 1;
+            if (units + width > max_length && pos != start) {
+                break;
+            }
+
+            units += width;
+            pos = std::min(pos + bytes, text.size());
+            if (lead == '\n') {
+                line_end = pos;
+            }
+        }
+
+        if (pos == text.size()) {
+            chunks.push_back(text.substr(start));
+            break;
+        }
+
+        const size_t end = line_end != std::string_view::npos ? line_end : pos;
+        chunks.push_back(text.substr(start, end - start));
+        start = end;
+    }
+
+    return chunks;
+}
+
+size_t Utf16Length(std::string_view text) {
+    size_t units = 0;
+    for (const char c : text) {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        // Продолжения UTF-8 не считаем, четырехбайтовые символы занимают две единицы
+        if ((byte & 0xC0) != 0x80) {
+            units += byte >= 0xF0 ? 2 : 1;
+        }
+    }
+    return units;
+}
+
+OutgoingMessage TakeCoalescedMessage(std::deque<OutgoingMessage>& queue, size_t max_length) {
+    static constexpr std::string_view SEPARATOR = "\n\n";
+
+    if (queue.empty()) {
+        return {};
+    }
+
+    OutgoingMessage message = std::move(queue.front());
+    queue.pop_front();
+
+    size_t units = Utf16Length(message.text);
+    if (units > max_length) {
+        const size_t first = SplitMessageText(message.text, max_length).front().size();
+        if (message.edit_message_id == 0) {
+            // Клавиатура уходит с последней частью
+            OutgoingMessage rest{message.chat_id, message.text.substr(first),
+                                 std::move(message.reply_markup)};
+            queue.push_front(std::move(rest));
+            message.reply_markup = nullptr;
+        }
+        message.text.resize(first);
+        return message;
+    }
+
+    if (!message.IsPlain()) {
+        return message;
+    }
+    while (!queue.empty() && queue.front().IsPlain()) {
+        const size_t next_units = Utf16Length(queue.front().text);
+        if (units + SEPARATOR.size() + next_units > max_length) {
+            break;
+        }
+        message.text += SEPARATOR;
+        message.text += queue.front().text;
+        units += SEPARATOR.size() + next_units;
+        queue.pop_front();
     }
+    return message;
 }
 
 }  // namespace bot
\ No newline at end of file
@@ -1,26 +1,84 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <deque>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace bot {
 
+// Ограничение Telegram на длину сообщения (в UTF-16 единицах)
+constexpr size_t MAX_MESSAGE_LENGTH = 4096;
+
+// Делит текст на части не длиннее max_length, по возможности по границам строк
+std::vector<std::string_view> SplitMessageText(std::string_view text,
+                                               size_t max_length = MAX_MESSAGE_LENGTH);
+
+// Длина текста в UTF-16 единицах, как ее считает Telegram
+size_t Utf16Length(std::string_view text);
+
+// Сообщение бота: новый ответ или правка уже отправленного сообщения
+struct OutgoingMessage {
+    OutgoingMessage() = default;
+    OutgoingMessage(long chat_id, std::string text, nlohmann::json reply_markup = nullptr,
+                    long edit_message_id = 0)
+        : chat_id(chat_id),
+          text(std::move(text)),
+          reply_markup(std::move(reply_markup)),
+          edit_message_id(edit_message_id) {}
+
+    long chat_id = 0;
+    std::string text;
+    // Встроенная клавиатура (поле reply_markup Bot API), null - без клавиатуры
+    nlohmann::json reply_markup;
+    // Не 0 - заменить текст и клавиатуру этого сообщения вместо отправки нового
+    long edit_message_id = 0;
+
+    // Простой текст можно склеивать с соседними ответами
+    bool IsPlain() const { return reply_markup.is_null() && edit_message_id == 0; }
+};
+
+// Забирает из очереди подряд идущие простые ответы, пока они помещаются в одно
+// сообщение, и склеивает их через пустую строку. Сообщения с клавиатурой и правки
+// уходят по одному. Слишком длинный ответ делится: первая часть возвращается,
+// остаток с клавиатурой остается в начале очереди. Правку разделить нельзя,
+// поэтому ее текст обрезается
+OutgoingMessage TakeCoalescedMessage(std::deque<OutgoingMessage>& queue,
+                                     size_t max_length = MAX_MESSAGE_LENGTH);
+
+// Нажатие кнопки встроенной клавиатуры под сообщением бота
+struct CallbackQuery {
+    std::string id;
+    long chat_id = 0;
+    // Сообщение, к которому прикреплена клавиатура
+    long message_id = 0;
+    long update_id = 0;
+    std::string data;
+};
+
 class Message {
  public:
     using json = nlohmann::json;
     
     Message() = default;
     explicit Message(const json& data);
+    Message(long id, long chat_id, std::string text);
     
     long GetId() const { return id_; }
     long GetChatId() const { return chat_id_; }
+    // update_id обновления, в котором пришло сообщение, 0 - неизвестен
+    long GetUpdateId() const { return update_id_; }
+    void SetUpdateId(long update_id) { update_id_ = update_id; }
     const std::string& GetText() const { return text_; }
     bool IsCommand() const;
-    std::string GetCommand() const;
+    std::string_view GetCommand() const;
     
  private:
     long id_ = 0;
     long chat_id_ = 0;
+    long update_id_ = 0;
     std::string text_;
     bool is_command_ = false;
 };
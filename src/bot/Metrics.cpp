@@ -0,0 +1,125 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <format>
+#include <utility>
+
+namespace bot {
+
+namespace {
+
+// Границы гистограммы в единицах steady_clock, чтобы не переводить каждое значение в секунды
+constexpr std::array<int64_t, Histogram::BOUNDS.size()> MakeTickBounds() {
+    std::array<int64_t, Histogram::BOUNDS.size()> ticks{};
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        ticks[i] = static_cast<int64_t>(Histogram::BOUNDS[i] * Histogram::Duration::period::den /
+                                        Histogram::Duration::period::num);
+    }
+    return ticks;
+}
+
+constexpr std::array<int64_t, Histogram::BOUNDS.size()> TICK_BOUNDS = MakeTickBounds();
+
+std::string JoinLabels(const std::string& labels, const std::string& extra) {
+    if (labels.empty()) {
+        return extra.empty() ? "" : "{" + extra + "}";
+    }
+    return extra.empty() ? "{" + labels + "}" : "{" + labels + "," + extra + "}";
+}
+
+const char* GetTypeName(size_t index) {
+    static constexpr std::array<const char*, 3> TYPES = {"counter", "gauge", "histogram"};
+    return TYPES[index];
+}
+
+}  // namespace
+
+size_t GetThreadSlot() {
+    static std::atomic<size_t> next_slot = 0;
+    thread_local const size_t slot =
+        next_slot.fetch_add(1, std::memory_order_relaxed) % METRIC_SLOTS;
+    return slot;
+}
+
+uint64_t Counter::Get() const {
+    uint64_t total = 0;
+    for (const Slot& slot : slots_) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Histogram::Observe(Duration value) {
+    const int64_t ticks = value.count();
+    const size_t bucket = static_cast<size_t>(
+        std::ranges::lower_bound(TICK_BOUNDS, ticks) - TICK_BOUNDS.begin());
+    Slot& slot = slots_[GetThreadSlot()];
+    slot.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    slot.sum.fetch_add(ticks, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::Collect() const {
+    Snapshot snapshot;
+    for (const Slot& slot : slots_) {
+        for (size_t i = 0; i < slot.buckets.size(); ++i) {
+            const uint64_t count = slot.buckets[i].load(std::memory_order_relaxed);
+            snapshot.buckets[i] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum += Duration(slot.sum.load(std::memory_order_relaxed));
+    }
+    return snapshot;
+}
+
+void MetricsRegistry::Add(std::string name, std::string help, const Counter& counter,
+                          std::string labels) {
+    entries_.push_back({std::move(name), std::move(help), std::move(labels), &counter});
+}
+
+void MetricsRegistry::Add(std::string name, std::string help, const Gauge& gauge,
+                          std::string labels) {
+    entries_.push_back({std::move(name), std::move(help), std::move(labels), &gauge});
+}
+
+void MetricsRegistry::Add(std::string name, std::string help, const Histogram& histogram,
+                          std::string labels) {
+    entries_.push_back({std::move(name), std::move(help), std::move(labels), &histogram});
+}
+
+std::string MetricsRegistry::Render() const {
+    std::string out;
+    const std::string* previous = nullptr;
+    for (const Entry& entry : entries_) {
+        // HELP и TYPE пишутся один раз для всех серий метрики
+        if (previous == nullptr || *previous != entry.name) {
+            out += std::format("# HELP {} {}\n# TYPE {} {}\n", entry.name, entry.help, entry.name,
+                               GetTypeName(entry.metric.index()));
+        }
+        previous = &entry.name;
+
+        const std::string labels = JoinLabels(entry.labels, "");
+        if (const auto* counter = std::get_if<const Counter*>(&entry.metric)) {
+            out += std::format("{}{} {}\n", entry.name, labels, (*counter)->Get());
+        } else if (const auto* gauge = std::get_if<const Gauge*>(&entry.metric)) {
+            out += std::format("{}{} {}\n", entry.name, labels, (*gauge)->Get());
+        } else {
+            const Histogram::Snapshot snapshot = std::get<const Histogram*>(entry.metric)->Collect();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < Histogram::BOUNDS.size(); ++i) {
+                cumulative += snapshot.buckets[i];
+                out += std::format(
+                    "{}_bucket{} {}\n", entry.name,
+                    JoinLabels(entry.labels, std::format("le=\"{}\"", Histogram::BOUNDS[i])),
+                    cumulative);
+            }
+            out += std::format("{}_bucket{} {}\n", entry.name,
+                               JoinLabels(entry.labels, "le=\"+Inf\""), snapshot.count);
+            out += std::format("{}_sum{} {}\n", entry.name, labels,
+                               std::chrono::duration<double>(snapshot.sum).count());
+            out += std::format("{}_count{} {}\n", entry.name, labels, snapshot.count);
+        }
+    }
+    return out;
+}
+
+}  // namespace bot
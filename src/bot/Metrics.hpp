@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace bot {
+
+// Сколько ячеек у каждой метрики. Потоки получают ячейки по кругу, поэтому
+// при числе потоков до METRIC_SLOTS каждый пишет в свою
+inline constexpr size_t METRIC_SLOTS = 16;
+
+// Ячейка текущего потока
+size_t GetThreadSlot();
+
+// Счетчик без блокировок: каждый поток увеличивает свою ячейку в отдельной
+// кэш-линии, поэтому потоки не мешают друг другу. Ячейки суммируются только при чтении
+class Counter {
+ public:
+    void Add(uint64_t value = 1) {
+        slots_[GetThreadSlot()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t Get() const;
+
+ private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    std::array<Slot, METRIC_SLOTS> slots_;
+};
+
+// Текущее значение, например размер очереди
+class Gauge {
+ public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(int64_t value) { value_.fetch_add(value, std::memory_order_relaxed); }
+    int64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+    std::atomic<int64_t> value_ = 0;
+};
+
+// Гистограмма длительностей с фиксированными границами, ячейки по потокам как у Counter
+class Histogram {
+ public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    // Верхние границы корзин в секундах: от долей миллисекунды до длинного опроса
+    static constexpr std::array<double, 16> BOUNDS = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                                      0.05,   0.1,   0.25,   0.5,   1,    2.5,
+                                                      5,      10,    30,     60};
+
+    struct Snapshot {
+        // Число значений в каждой корзине, последняя - больше всех границ
+        std::array<uint64_t, BOUNDS.size() + 1> buckets{};
+        uint64_t count = 0;
+        Duration sum{};
+    };
+
+    void Observe(Duration value);
+    Snapshot Collect() const;
+
+ private:
+    struct alignas(64) Slot {
+        std::array<std::atomic<uint64_t>, BOUNDS.size() + 1> buckets{};
+        std::atomic<int64_t> sum{0};
+    };
+
+    std::array<Slot, METRIC_SLOTS> slots_;
+};
+
+// Замер длительности от создания до Stop() или удаления
+class ScopedTimer {
+ public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(&histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { Stop(); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void Stop() {
+        if (histogram_ != nullptr) {
+            histogram_->Observe(std::chrono::steady_clock::now() - start_);
+            histogram_ = nullptr;
+        }
+    }
+
+ private:
+    Histogram* histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Список метрик для выдачи в текстовом формате Prometheus. Метрики не копируются:
+// реестр хранит ссылки, а сами метрики остаются у тех, кто их обновляет.
+// Серии с одним именем и разными метками добавляются подряд
+class MetricsRegistry {
+ public:
+    // labels - готовые метки без скобок, например command="add"
+    void Add(std::string name, std::string help, const Counter& counter, std::string labels = "");
+    void Add(std::string name, std::string help, const Gauge& gauge, std::string labels = "");
+    void Add(std::string name, std::string help, const Histogram& histogram,
+             std::string labels = "");
+
+    std::string Render() const;
+
+ private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        std::string labels;
+        std::variant<const Counter*, const Gauge*, const Histogram*> metric;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+}  // namespace bot
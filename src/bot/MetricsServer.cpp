@@ -0,0 +1,48 @@
+#include "MetricsServer.hpp"
+
+#include <boost/beast/http/verb.hpp>
+
+#include <string_view>
+#include <utility>
+
+namespace bot {
+
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+
+namespace {
+
+constexpr std::string_view CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+HttpServerOptions MakeServerOptions(const MetricsOptions& options) {
+    HttpServerOptions server_options;
+    server_options.listen_address = options.listen_address;
+    server_options.port = options.port;
+    // Запросы Prometheus короткие
+    server_options.body_limit = 8 * 1024;
+    return server_options;
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(net::any_io_executor executor, MetricsOptions options,
+                             RenderFunction render)
+    : options_(std::move(options)),
+      render_(std::move(render)),
+      server_(std::move(executor), MakeServerOptions(options_),
+              [this](const HttpRequest& request) -> net::awaitable<HttpServerResponse> {
+                  co_return HandleRequest(request);
+              }) {}
+
+HttpServerResponse MetricsServer::HandleRequest(const HttpRequest& request) {
+    if (request.target() != options_.path) {
+        return MakeHttpResponse(request, http::status::not_found, "Not found\n", CONTENT_TYPE);
+    }
+    if (request.method() != http::verb::get) {
+        return MakeHttpResponse(request, http::status::method_not_allowed,
+                                "Method not allowed\n", CONTENT_TYPE);
+    }
+    return MakeHttpResponse(request, http::status::ok, render_(), CONTENT_TYPE);
+}
+
+}  // namespace bot
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "HttpServer.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+
+#include <functional>
+#include <string>
+
+namespace bot {
+
+struct MetricsOptions {
+    // Без явного включения порт не открывается
+    bool enabled = false;
+    // Метрики не секретны, но и наружу их выставлять незачем
+    std::string listen_address = "127.0.0.1";
+    unsigned short port = 9464;
+    std::string path = "/metrics";
+};
+
+// HTTP сервер, отдающий метрики в текстовом формате Prometheus по GET-запросу
+class MetricsServer {
+ public:
+    using RenderFunction = std::function<std::string()>;
+
+    MetricsServer(boost::asio::any_io_executor executor, MetricsOptions options,
+                  RenderFunction render);
+
+    void Listen() { server_.Listen(); }
+    boost::asio::awaitable<void> Run() { return server_.Run(); }
+    void Stop() { server_.Stop(); }
+
+    unsigned short GetPort() const { return server_.GetPort(); }
+
+    HttpServerResponse HandleRequest(const HttpRequest& request);
+
+ private:
+    MetricsOptions options_;
+    RenderFunction render_;
+    HttpServer server_;
+};
+
+}  // namespace bot
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Message.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace bot {
+
+// Отправка ответов обработчиком команды. Как и FunctionRef, не владеет функцией
+// и действует только на время вызова. Функция принимает OutgoingMessage или,
+// если клавиатуры и правки не нужны, только текст и чат: тогда правка
+// превращается в новый ответ, а клавиатура отбрасывается
+class Reply {
+ public:
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, Reply> &&
+                 std::is_invocable_v<F&, OutgoingMessage>)
+    Reply(F&& function) noexcept
+        : object_(const_cast<void*>(static_cast<const void*>(std::addressof(function)))),
+          call_([](void* object, OutgoingMessage message) {
+              std::invoke(*static_cast<std::remove_reference_t<F>*>(object), std::move(message));
+          }) {}
+
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, Reply> &&
+                 !std::is_invocable_v<F&, OutgoingMessage> &&
+                 std::is_invocable_v<F&, const std::string&, long>)
+    Reply(F&& function) noexcept
+        : object_(const_cast<void*>(static_cast<const void*>(std::addressof(function)))),
+          call_([](void* object, OutgoingMessage message) {
+              std::invoke(*static_cast<std::remove_reference_t<F>*>(object), message.text,
+                          message.chat_id);
+          }) {}
+
+    void operator()(const std::string& text, long chat_id) const {
+        call_(object_, OutgoingMessage{chat_id, text});
+    }
+    void operator()(OutgoingMessage message) const { call_(object_, std::move(message)); }
+
+ private:
+    void* object_;
+    void (*call_)(void*, OutgoingMessage);
+};
+
+}  // namespace bot
@@ -0,0 +1,50 @@
+#include "TokenBucket.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace bot {
+
+TokenBucket::TokenBucket(double rate, double burst, Clock::time_point now)
+    : rate_(rate), burst_(std::max(burst, 1.0)), tokens_(burst_), updated_(now) {
+    // Отрицательная проверка пропустила бы NaN
+    if (!(rate > 0.0)) {
+        throw std::invalid_argument(std::format("Token bucket rate must be positive: {}", rate));
+    }
+}
+
+TokenBucket::Clock::duration TokenBucket::Reserve(Clock::time_point now) {
+    // После Pause() отсчет идет от конца паузы
+    const Clock::time_point from = std::max(updated_, now);
+    tokens_ = TokensAt(from) - 1.0;
+    updated_ = from;
+    Clock::duration wait = from - now;
+    if (tokens_ < 0.0) {
+        wait += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(-tokens_ / rate_));
+    }
+    return wait;
+}
+
+void TokenBucket::Pause(Clock::duration duration, Clock::time_point now) {
+    const Clock::time_point until = now + duration;
+    if (until <= updated_) {
+        return;
+    }
+    // Токены, накопленные до паузы, не тратятся пачкой сразу после нее
+    tokens_ = std::min(TokensAt(std::max(updated_, now)), 1.0);
+    updated_ = until;
+}
+
+bool TokenBucket::IsFull(Clock::time_point now) const { return TokensAt(now) >= burst_; }
+
+double TokenBucket::TokensAt(Clock::time_point now) const {
+    if (now <= updated_) {
+        return tokens_;
+    }
+    const double elapsed = std::chrono::duration<double>(now - updated_).count();
+    return std::min(burst_, tokens_ + elapsed * rate_);
+}
+
+}  // namespace bot
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+namespace bot {
+
+// Ведро токенов: rate токенов в секунду, не больше burst подряд.
+// Время передается явно, чтобы поведение было детерминированным
+class TokenBucket {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    // Бросает std::invalid_argument, если rate не положительный
+    TokenBucket(double rate, double burst, Clock::time_point now = Clock::now());
+
+    // Забирает токен и возвращает, сколько нужно подождать до его появления.
+    // Токен можно взять в долг: следующие вызовы будут ждать дольше
+    Clock::duration Reserve(Clock::time_point now = Clock::now());
+
+    // Не выдает токены в течение duration, например после 429 с retry_after.
+    // Затем ведро пополняется с обычной скоростью
+    void Pause(Clock::duration duration, Clock::time_point now = Clock::now());
+
+    // Ведро полное: его состояние ничем не отличается от нового
+    bool IsFull(Clock::time_point now = Clock::now()) const;
+
+ private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    Clock::time_point updated_;
+
+    double TokensAt(Clock::time_point now) const;
+};
+
+}  // namespace bot
@@ -0,0 +1,293 @@
+#include "UpdateDecoder.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace bot {
+
+namespace {
+
+using json = nlohmann::json;
+
+// Объекты и массивы, внутри которых есть нужные поля. Все остальное пропускается
+enum class Frame { RESPONSE, RESULT, UPDATE, CALLBACK, MESSAGE, CHAT };
+
+// Ключи, которые нас интересуют. Ключ запоминается перечислением,
+// поэтому разбор не копирует имена полей
+enum class Key {
+    OTHER,
+    OK,
+    RESULT,
+    UPDATE_ID,
+    MESSAGE,
+    CALLBACK_QUERY,
+    MESSAGE_ID,
+    CHAT,
+    ID,
+    TEXT,
+    DATA
+};
+
+Key ClassifyKey(Frame frame, std::string_view key) {
+    switch (frame) {
+        case Frame::RESPONSE:
+            return key == "ok" ? Key::OK : key == "result" ? Key::RESULT : Key::OTHER;
+        case Frame::UPDATE:
+            return key == "update_id"        ? Key::UPDATE_ID
+                   : key == "message"        ? Key::MESSAGE
+                   : key == "callback_query" ? Key::CALLBACK_QUERY
+                                             : Key::OTHER;
+        case Frame::CALLBACK:
+            return key == "id"        ? Key::ID
+                   : key == "message" ? Key::MESSAGE
+                   : key == "data"    ? Key::DATA
+                                      : Key::OTHER;
+        case Frame::MESSAGE:
+            return key == "message_id" ? Key::MESSAGE_ID
+                   : key == "chat"     ? Key::CHAT
+                   : key == "text"     ? Key::TEXT
+                                       : Key::OTHER;
+        case Frame::CHAT:
+            return key == "id" ? Key::ID : Key::OTHER;
+        default:
+            return Key::OTHER;
+    }
+}
+
+class UpdateSax {
+ public:
+    // root - чем является корневой объект: ответом API или одним обновлением
+    UpdateSax(Frame root, std::vector<Update>& updates) : root_(root), updates_(updates) {}
+
+    bool IsOk() const { return ok_; }
+    bool HasRoot() const { return has_root_; }
+
+    bool null() { return Value(false); }
+    bool boolean(bool value) {
+        if (skip_ == 0 && Top() == Frame::RESPONSE && key_ == Key::OK) {
+            ok_ = value;
+        }
+        return true;
+    }
+    bool number_integer(json::number_integer_t value) { return Number(value); }
+    bool number_unsigned(json::number_unsigned_t value) {
+        return Number(static_cast<int64_t>(value));
+    }
+    bool number_float(json::number_float_t, const json::string_t&) { return Value(false); }
+    bool binary(json::binary_t&) { return Value(false); }
+
+    bool string(json::string_t& value) {
+        if (skip_ == 0 && Top() == Frame::MESSAGE && key_ == Key::TEXT) {
+            // Текст сообщения с кнопкой не нужен
+            if (!InCallback()) {
+                text_ = std::move(value);
+            }
+            return true;
+        }
+        if (skip_ == 0 && Top() == Frame::CALLBACK && (key_ == Key::ID || key_ == Key::DATA)) {
+            CallbackQuery& query = *updates_.back().callback_query;
+            (key_ == Key::ID ? query.id : query.data) = std::move(value);
+            return true;
+        }
+        return Value(false);
+    }
+
+    bool key(json::string_t& key) {
+        if (skip_ == 0) {
+            key_ = ClassifyKey(Top(), key);
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        if (skip_ > 0) {
+            ++skip_;
+            return true;
+        }
+        if (depth_ == 0) {
+            has_root_ = true;
+            return Enter(root_);
+        }
+        if (Top() == Frame::RESULT) {
+            updates_.emplace_back();
+            return Enter(Frame::UPDATE);
+        }
+        if (Top() == Frame::UPDATE && key_ == Key::CALLBACK_QUERY) {
+            updates_.back().callback_query.emplace();
+            return Enter(Frame::CALLBACK);
+        }
+        if ((Top() == Frame::UPDATE || Top() == Frame::CALLBACK) && key_ == Key::MESSAGE) {
+            BeginMessage();
+            return Enter(Frame::MESSAGE);
+        }
+        if (Top() == Frame::MESSAGE && key_ == Key::CHAT) {
+            return Enter(Frame::CHAT);
+        }
+        return Value(true);
+    }
+
+    bool end_object() {
+        if (skip_ > 0) {
+            --skip_;
+            return true;
+        }
+        const Frame frame = Top();
+        if (frame != Frame::MESSAGE && frame != Frame::UPDATE) {
+            return Leave();
+        }
+        Update& update = updates_.back();
+        if (frame == Frame::MESSAGE && valid_) {
+            if (InCallback()) {
+                update.callback_query->chat_id = chat_id_;
+                update.callback_query->message_id = message_id_;
+            } else {
+                update.message.emplace(message_id_, chat_id_, std::move(text_));
+            }
+        }
+        // update_id может идти и после сообщения
+        if (frame == Frame::UPDATE && update.message.has_value()) {
+            update.message->SetUpdateId(update.id);
+        }
+        if (frame == Frame::UPDATE && update.callback_query.has_value()) {
+            CallbackQuery& query = *update.callback_query;
+            // Без id на нажатие не ответить, без чата и сообщения нечего править
+            if (query.id.empty() || query.chat_id == 0 || query.message_id == 0) {
+                update.callback_query.reset();
+            } else {
+                query.update_id = update.id;
+            }
+        }
+        return Leave();
+    }
+
+    bool start_array(std::size_t) {
+        if (skip_ == 0 && depth_ > 0 && Top() == Frame::RESPONSE && key_ == Key::RESULT) {
+            return Enter(Frame::RESULT);
+        }
+        return Value(true);
+    }
+
+    bool end_array() {
+        if (skip_ > 0) {
+            --skip_;
+            return true;
+        }
+        return Leave();
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+        throw std::runtime_error("Failed to parse JSON response: " + std::string(e.what()));
+    }
+
+ private:
+    static constexpr size_t MAX_DEPTH = 6;
+
+    Frame root_;
+    std::vector<Update>& updates_;
+    std::array<Frame, MAX_DEPTH> frames_{};
+    size_t depth_ = 0;
+    // Глубина вложенности внутри пропускаемого значения
+    size_t skip_ = 0;
+    Key key_ = Key::OTHER;
+    bool ok_ = false;
+    bool has_root_ = false;
+
+    // Поля текущего сообщения
+    long message_id_ = 0;
+    long chat_id_ = 0;
+    std::string text_;
+    bool valid_ = true;
+
+    Frame Top() const { return depth_ == 0 ? root_ : frames_[depth_ - 1]; }
+    // Текущее сообщение - то, к которому прикреплена нажатая кнопка
+    bool InCallback() const { return depth_ >= 2 && frames_[depth_ - 2] == Frame::CALLBACK; }
+
+    bool Enter(Frame frame) {
+        frames_[depth_++] = frame;
+        key_ = Key::OTHER;
+        return true;
+    }
+
+    bool Leave() {
+        --depth_;
+        key_ = Key::OTHER;
+        return true;
+    }
+
+    void BeginMessage() {
+        message_id_ = 0;
+        chat_id_ = 0;
+        text_.clear();
+        valid_ = true;
+    }
+
+    bool Number(int64_t value) {
+        if (skip_ > 0 || depth_ == 0) {
+            return true;
+        }
+        const Frame frame = Top();
+        if (frame == Frame::UPDATE && key_ == Key::UPDATE_ID) {
+            updates_.back().id = static_cast<long>(value);
+        } else if (frame == Frame::MESSAGE && key_ == Key::MESSAGE_ID) {
+            message_id_ = static_cast<long>(value);
+        } else if (frame == Frame::CHAT && key_ == Key::ID) {
+            chat_id_ = static_cast<long>(value);
+        } else {
+            return Value(false);
+        }
+        return true;
+    }
+
+    // Значение, которое не сохраняется. Если это нужное поле неверного типа,
+    // сообщение отбрасывается, как это делал конструктор Message из JSON
+    bool Value(bool nested) {
+        if (skip_ > 0) {
+            skip_ += nested ? 1 : 0;
+            return true;
+        }
+        if (depth_ > 0) {
+            const Key key = key_;
+            const Frame frame = Top();
+            if ((frame == Frame::MESSAGE &&
+                 (key == Key::MESSAGE_ID || key == Key::TEXT || key == Key::CHAT)) ||
+                (frame == Frame::CHAT && key == Key::ID)) {
+                valid_ = false;
+            }
+        }
+        if (nested) {
+            skip_ = 1;
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+bool DecodeUpdates(std::string_view body, std::vector<Update>& updates) {
+    UpdateSax sax(Frame::RESPONSE, updates);
+    json::sax_parse(body.begin(), body.end(), &sax);
+    return sax.IsOk();
+}
+
+std::optional<Update> DecodeUpdate(std::string_view body) {
+    std::vector<Update> updates(1);
+    try {
+        // Корневой объект сразу считается обновлением
+        UpdateSax sax(Frame::UPDATE, updates);
+        json::sax_parse(body.begin(), body.end(), &sax);
+        if (!sax.HasRoot()) {
+            return std::nullopt;
+        }
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+    return std::move(updates.front());
+}
+
+}  // namespace bot
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Message.hpp"
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace bot {
+
+// Обновление в том виде, в каком его использует бот: только нужные поля
+struct Update {
+    long id = 0;
+    // Нет, если обновление не является сообщением или его поля неверного типа
+    std::optional<Message> message;
+    // Нажатие кнопки под сообщением бота, если в нем есть id, чат и сообщение
+    std::optional<CallbackQuery> callback_query;
+};
+
+// Потоковый (SAX) разбор ответа getUpdates без построения дерева JSON:
+// из каждого обновления берутся update_id, message_id, chat.id и text, а у
+// callback_query - id, data и сообщение с кнопкой. Остальные поля пропускаются. Обновления дописываются в updates, поэтому
+// вектор можно переиспользовать между запросами.
+// Возвращает значение поля ok. Бросает std::runtime_error, если JSON некорректен
+bool DecodeUpdates(std::string_view body, std::vector<Update>& updates);
+
+// Одно обновление, например тело запроса webhook. nullopt, если это не объект JSON
+std::optional<Update> DecodeUpdate(std::string_view body);
+
+}  // namespace bot
@@ -0,0 +1,31 @@
+#include "UpdateQueue.hpp"
+
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <utility>
+
+namespace bot {
+
+namespace net = boost::asio;
+
+UpdateQueue::UpdateQueue(net::any_io_executor executor) : signal_(std::move(executor)) {}
+
+void UpdateQueue::Push(Update update) {
+    updates_.push_back(std::move(update));
+    signal_.cancel();
+}
+
+net::awaitable<Update> UpdateQueue::Pop() {
+    while (updates_.empty()) {
+        signal_.expires_at(net::steady_timer::time_point::max());
+        boost::system::error_code ec;
+        co_await signal_.async_wait(net::redirect_error(net::use_awaitable, ec));
+    }
+
+    Update update = std::move(updates_.front());
+    updates_.pop_front();
+    co_return update;
+}
+
+}  // namespace bot
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "UpdateDecoder.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <cstddef>
+#include <deque>
+
+namespace bot {
+
+// Очередь входящих обновлений между источниками (длинный опрос, webhook)
+// и обработчиком команд. Все вызовы выполняются на исполнителе очереди
+class UpdateQueue {
+ public:
+    explicit UpdateQueue(boost::asio::any_io_executor executor);
+
+    void Push(Update update);
+    // Ждет, пока в очереди появится обновление
+    boost::asio::awaitable<Update> Pop();
+
+    size_t Size() const { return updates_.size(); }
+
+ private:
+    std::deque<Update> updates_;
+    // Таймер без срока служит сигналом: Push отменяет ожидание
+    boost::asio::steady_timer signal_;
+};
+
+}  // namespace bot
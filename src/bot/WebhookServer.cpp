@@ -0,0 +1,110 @@
+#include "WebhookServer.hpp"
+
+#include <boost/beast/http/verb.hpp>
+
+#include <optional>
+#include <random>
+#include <string_view>
+#include <utility>
+
+namespace bot {
+
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+
+namespace {
+
+// Сравнение за время, не зависящее от места первого расхождения
+bool SecretEquals(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    unsigned char diff = 0;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        diff |= static_cast<unsigned char>(lhs[i] ^ rhs[i]);
+    }
+    return diff == 0;
+}
+
+constexpr std::string_view CONTENT_TYPE = "text/plain";
+
+WebhookOptions WithSecret(WebhookOptions options) {
+    if (options.secret_token.empty()) {
+        options.secret_token = GenerateSecretToken();
+    }
+    return options;
+}
+
+HttpServerOptions MakeServerOptions(const WebhookOptions& options) {
+    HttpServerOptions server_options;
+    server_options.listen_address = options.listen_address;
+    server_options.port = options.port;
+    server_options.body_limit = WebhookServer::MAX_BODY_SIZE;
+    server_options.cert_file = options.cert_file;
+    server_options.key_file = options.key_file;
+    return server_options;
+}
+
+}  // namespace
+
+std::string GenerateSecretToken(size_t length) {
+    static constexpr std::string_view ALPHABET =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-";
+
+    std::random_device device;
+    std::uniform_int_distribution<size_t> distribution(0, ALPHABET.size() - 1);
+
+    std::string token;
+    token.reserve(length);
+    for (size_t i = 0; i < length; ++i) {
+        token += ALPHABET[distribution(device)];
+    }
+    return token;
+}
+
+WebhookServer::WebhookServer(net::any_io_executor executor, WebhookOptions options,
+                             UpdateHandler handler)
+    : options_(WithSecret(std::move(options))),
+      handler_(std::move(handler)),
+      server_(std::move(executor), MakeServerOptions(options_),
+              [this](const HttpRequest& request) -> net::awaitable<HttpServerResponse> {
+                  co_return HandleRequest(request);
+              }) {}
+
+void WebhookServer::Stop() {
+    stopped_ = true;
+    server_.Stop();
+}
+
+HttpServerResponse WebhookServer::HandleRequest(const HttpRequest& request) {
+    if (request.target() != options_.path) {
+        return MakeHttpResponse(request, http::status::not_found, "Not found", CONTENT_TYPE);
+    }
+    if (request.method() != http::verb::post) {
+        return MakeHttpResponse(request, http::status::method_not_allowed, "Method not allowed",
+                                CONTENT_TYPE);
+    }
+
+    const auto secret = request.find(SECRET_HEADER);
+    if (secret == request.end() || !SecretEquals(secret->value(), options_.secret_token)) {
+        return MakeHttpResponse(request, http::status::unauthorized, "Invalid secret token",
+                                CONTENT_TYPE);
+    }
+
+    if (stopped_) {
+        HttpServerResponse response = MakeHttpResponse(
+            request, http::status::service_unavailable, "Shutting down", CONTENT_TYPE);
+        response.keep_alive(false);
+        return response;
+    }
+
+    std::optional<Update> update = DecodeUpdate(request.body());
+    if (!update.has_value()) {
+        return MakeHttpResponse(request, http::status::bad_request, "Invalid update", CONTENT_TYPE);
+    }
+
+    handler_(std::move(*update));
+    return MakeHttpResponse(request, http::status::ok, "ok", CONTENT_TYPE);
+}
+
+}  // namespace bot
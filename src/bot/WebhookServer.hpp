@@ -0,0 +1,68 @@
+#pragma once
+
+#include "HttpServer.hpp"
+#include "UpdateDecoder.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace bot {
+
+struct WebhookOptions {
+    // Публичный HTTPS адрес, который регистрируется через setWebhook.
+    // Пустой адрес отключает webhook: бот работает длинным опросом
+    std::string public_url;
+    std::string listen_address = "0.0.0.0";
+    unsigned short port = 8443;
+    std::string path = "/webhook";
+    // Значение заголовка X-Telegram-Bot-Api-Secret-Token. Пустое - сгенерировать
+    std::string secret_token;
+    // Сертификат и ключ для HTTPS. Без них сервер принимает обычный HTTP,
+    // например за обратным прокси
+    std::string cert_file;
+    std::string key_file;
+
+    bool IsEnabled() const { return !public_url.empty(); }
+};
+
+// Случайный секрет из символов, допустимых для secret_token в setWebhook
+std::string GenerateSecretToken(size_t length = 32);
+
+// Встроенный HTTP(S) сервер для приема обновлений от Telegram.
+// Проверяет путь, метод и секретный заголовок и передает разобранное
+// обновление обработчику
+class WebhookServer {
+ public:
+    using UpdateHandler = std::function<void(Update update)>;
+
+    static constexpr std::string_view SECRET_HEADER = "X-Telegram-Bot-Api-Secret-Token";
+    static constexpr size_t MAX_BODY_SIZE = 1024 * 1024;
+
+    WebhookServer(boost::asio::any_io_executor executor, WebhookOptions options,
+                  UpdateHandler handler);
+
+    void Listen() { server_.Listen(); }
+    boost::asio::awaitable<void> Run() { return server_.Run(); }
+    // Закрывает порт. Уже открытые соединения Telegram получают 503 и закрываются:
+    // ответ 200 значил бы, что обновление доставлено, и Telegram не прислал бы его снова
+    void Stop();
+
+    unsigned short GetPort() const { return server_.GetPort(); }
+    const WebhookOptions& GetOptions() const { return options_; }
+
+    // Ответ на один запрос: отдельно от сети, чтобы логику было просто проверить
+    HttpServerResponse HandleRequest(const HttpRequest& request);
+
+ private:
+    WebhookOptions options_;
+    UpdateHandler handler_;
+    bool stopped_ = false;
+    HttpServer server_;
+};
+
+}  // namespace bot
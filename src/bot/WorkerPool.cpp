@@ -0,0 +1,106 @@
+#include "WorkerPool.hpp"
+
+#include "Trace.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+namespace bot {
+
+namespace net = boost::asio;
+
+namespace {
+
+size_t ResolveThreadCount(size_t threads) {
+    if (threads != 0) {
+        return threads;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Потоки пула создает asio, поэтому имя в трассе дается при первой задаче
+void NameWorkerThread() {
+    thread_local bool named = false;
+    if (!named) {
+        trace::SetThreadName("worker");
+        named = true;
+    }
+}
+
+}  // namespace
+
+WorkerPool::WorkerPool(size_t threads)
+    : threads_(ResolveThreadCount(threads)), pool_(threads_) {}
+
+WorkerPool::~WorkerPool() { Join(); }
+
+void WorkerPool::Submit(long key, Task task) {
+    bool schedule = false;
+    {
+        std::lock_guard lock(mutex_);
+        auto [it, inserted] = queues_.try_emplace(key);
+        it->second.push_back(std::move(task));
+        schedule = inserted;
+
+        ++submitted_;
+        ++queued_;
+        max_queued_ = std::max(max_queued_, queued_);
+    }
+
+    if (schedule) {
+        net::post(pool_, [this, key] { Drain(key); });
+    }
+}
+
+void WorkerPool::Join() { pool_.join(); }
+
+WorkerPool::Stats WorkerPool::GetStats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats;
+    stats.threads = threads_;
+    stats.queued = queued_;
+    stats.max_queued = max_queued_;
+    stats.active_keys = queues_.size();
+    stats.submitted = submitted_;
+    stats.completed = completed_;
+    return stats;
+}
+
+void WorkerPool::Drain(long key) {
+    NameWorkerThread();
+    for (size_t done = 0;; ++done) {
+        Task task;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = queues_.find(key);
+            if (it->second.empty()) {
+                queues_.erase(it);
+                return;
+            }
+            if (done == BATCH_SIZE) {
+                // Остальные задачи ключа пойдут в конец очереди пула
+                net::post(pool_, [this, key] { Drain(key); });
+                return;
+            }
+            task = std::move(it->second.front());
+            it->second.pop_front();
+            --queued_;
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Worker task failed: " << e.what() << std::endl;
+        }
+
+        std::lock_guard lock(mutex_);
+        ++completed_;
+    }
+}
+
+}  // namespace bot
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace bot {
+
+// Пул потоков для обработки команд. Задачи с разными ключами (чатами)
+// выполняются параллельно, задачи с одним ключом - строго по очереди
+class WorkerPool {
+ public:
+    using Task = std::function<void()>;
+
+    struct Stats {
+        size_t threads = 0;
+        // Задачи, ожидающие выполнения
+        size_t queued = 0;
+        size_t max_queued = 0;
+        // Ключи, у которых есть ожидающие или выполняющиеся задачи
+        size_t active_keys = 0;
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+    };
+
+    // Сколько задач одного ключа выполняется подряд, прежде чем уступить поток другим
+    static constexpr size_t BATCH_SIZE = 16;
+
+    // threads = 0 - по числу ядер
+    explicit WorkerPool(size_t threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Submit(long key, Task task);
+    // Дожидается выполнения всех задач и останавливает потоки
+    void Join();
+
+    Stats GetStats() const;
+
+ private:
+    size_t threads_;
+    boost::asio::thread_pool pool_;
+
+    mutable std::mutex mutex_;
+    // Очередь есть у ключа, пока для него запланирован или работает Drain
+    std::unordered_map<long, std::deque<Task>> queues_;
+    size_t queued_ = 0;
+    size_t max_queued_ = 0;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+
+    void Drain(long key);
+};
+
+}  // namespace bot
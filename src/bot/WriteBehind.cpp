@@ -0,0 +1,109 @@
+#include "WriteBehind.hpp"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <utility>
+
+namespace bot {
+
+WriteBehind::WriteBehind(FlushFunction flush, WriteBehindOptions options)
+    : flush_(std::move(flush)), options_(options), thread_([this] { Run(); }) {}
+
+WriteBehind::~WriteBehind() {
+    try {
+        Stop();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save pending changes: " << e.what() << std::endl;
+    }
+}
+
+void WriteBehind::Notify() {
+    std::lock_guard lock(mutex_);
+    const Clock::time_point now = Clock::now();
+    if (pending_ == 0) {
+        first_change_ = now;
+    }
+    last_change_ = now;
+    ++pending_;
+
+    // Поток ждет либо первое изменение, либо переполнение: остальные изменения
+    // только сдвигают срок, который он пересчитает сам
+    if (pending_ == 1 || pending_ >= options_.max_pending) {
+        changed_.notify_one();
+    }
+}
+
+void WriteBehind::Flush() {
+    {
+        std::lock_guard lock(mutex_);
+        pending_ = 0;
+    }
+    std::lock_guard flush_lock(flush_mutex_);
+    flush_();
+    ++flushes_;
+}
+
+void WriteBehind::Stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    changed_.notify_one();
+    thread_.join();
+    Flush();
+}
+
+void WriteBehind::Run() {
+    trace::SetThreadName("list writer");
+    std::unique_lock lock(mutex_);
+    while (true) {
+        changed_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_) {
+            break;
+        }
+
+        // Ждем паузу в изменениях, но не дольше max_delay с первого из них
+        while (!stop_ && pending_ < options_.max_pending) {
+            const Clock::time_point deadline = std::min(last_change_ + options_.debounce,
+                                                        first_change_ + options_.max_delay);
+            if (Clock::now() >= deadline) {
+                break;
+            }
+            changed_.wait_until(lock, deadline);
+        }
+        if (stop_) {
+            break;
+        }
+
+        pending_ = 0;
+        lock.unlock();
+        RunFlush();
+        lock.lock();
+    }
+}
+
+void WriteBehind::RunFlush() {
+    try {
+        std::lock_guard flush_lock(flush_mutex_);
+        flush_();
+        ++flushes_;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save changes, will retry: " << e.what() << std::endl;
+        // Несохраненные изменения остаются, повторяем после обычной задержки
+        std::lock_guard lock(mutex_);
+        const Clock::time_point now = Clock::now();
+        if (pending_ == 0) {
+            first_change_ = now;
+        }
+        last_change_ = now;
+        ++pending_;
+    }
+}
+
+}  // namespace bot
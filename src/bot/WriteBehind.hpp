@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace bot {
+
+struct WriteBehindOptions {
+    // Запись после паузы в изменениях
+    std::chrono::milliseconds debounce{200};
+    // Дольше изменение не остается несохраненным, даже если изменения идут подряд.
+    // Это и есть окно, в котором данные можно потерять при сбое
+    std::chrono::milliseconds max_delay{2000};
+    // После стольких изменений запись начинается сразу
+    size_t max_pending = 100;
+};
+
+// Отложенная запись: изменения только отмечаются через Notify(), а функция
+// записи вызывается фоновым потоком, когда изменения затихли, накопилось
+// слишком много изменений или вышло максимальное время ожидания
+class WriteBehind {
+ public:
+    using Clock = std::chrono::steady_clock;
+    using FlushFunction = std::function<void()>;
+
+    explicit WriteBehind(FlushFunction flush, WriteBehindOptions options = {});
+    // Останавливает поток и записывает оставшиеся изменения
+    ~WriteBehind();
+
+    WriteBehind(const WriteBehind&) = delete;
+    WriteBehind& operator=(const WriteBehind&) = delete;
+
+    void Notify();
+    // Синхронная запись в вызывающем потоке. Ошибки записи бросаются
+    void Flush();
+    void Stop();
+
+    uint64_t GetFlushCount() const { return flushes_; }
+
+ private:
+    FlushFunction flush_;
+    WriteBehindOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    size_t pending_ = 0;
+    Clock::time_point first_change_;
+    Clock::time_point last_change_;
+    bool stop_ = false;
+
+    // Запись из фонового потока и явный Flush() не выполняются одновременно
+    std::mutex flush_mutex_;
+    std::atomic<uint64_t> flushes_ = 0;
+
+    // Объявлен последним: запускается, когда остальные поля уже готовы
+    std::thread thread_;
+
+    void Run();
+    void RunFlush();
+};
+
+}  // namespace bot
@@ -0,0 +1,97 @@
+#include "Batch.hpp"
+
+#include "Executor.hpp"
+#include "Parser.hpp"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace cli {
+
+std::string ReadBatchScript(std::string_view source) {
+    std::ostringstream script;
+    if (source == "-") {
+        script << std::cin.rdbuf();
+        return script.str();
+    }
+
+    std::ifstream fin(std::string(source), std::ios::binary);
+    if (!fin) {
+        throw std::runtime_error(std::format("Failed to open batch file: {}", source));
+    }
+    script << fin.rdbuf();
+    return script.str();
+}
+
+BatchStats RunBatch(task::TaskManager& manager, std::string_view script, size_t save_every,
+                    task::OutputBuffer& out, std::ostream& err) {
+    BatchStats stats;
+
+    parser::Parser command_parser;
+    Executor executor(manager);
+    std::vector<std::string_view> words;
+
+    size_t unsaved = 0;
+    size_t line_number = 0;
+    size_t pos = 0;
+    while (pos < script.size()) {
+        size_t end = script.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = script.size();
+        }
+        std::string_view line = script.substr(pos, end - pos);
+        pos = end + 1;
+        ++line_number;
+
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+
+        try {
+            parser::SplitWords(line, words);
+            if (words.empty() || words.front().starts_with('#')) {
+                continue;
+            }
+
+            command_parser.Parse(words);
+            if (command_parser.GetTypeCommand() == parser::TypeCommand::BATCH) {
+                throw std::invalid_argument("Nested batch is not supported");
+            }
+            if (command_parser.GetTypeCommand() == parser::TypeCommand::CONFIG && unsaved != 0) {
+                // После config менеджер откроет другой список - сохраняем текущий
+                manager.Save();
+                unsaved = 0;
+                ++stats.saves;
+            }
+
+            if (executor.Execute(command_parser, out)) {
+                ++unsaved;
+            }
+            ++stats.executed;
+
+            if (save_every != 0 && unsaved >= save_every) {
+                manager.Save();
+                unsaved = 0;
+                ++stats.saves;
+            }
+        } catch (const std::exception& e) {
+            // Сбрасываем накопленный вывод, чтобы ошибка шла после него
+            out.Flush();
+            err << std::format("line {}: {}\n", line_number, e.what());
+            ++stats.failed;
+        }
+    }
+
+    if (unsaved != 0) {
+        manager.Save();
+        ++stats.saves;
+    }
+
+    return stats;
+}
+
+}  // namespace cli
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Output.hpp"
+#include "Task.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace cli {
+
+struct BatchStats {
+    size_t executed = 0;
+    size_t failed = 0;
+    size_t saves = 0;
+};
+
+// Читает скрипт целиком из файла или из стандартного ввода ("-")
+std::string ReadBatchScript(std::string_view source);
+
+// Выполняет скрипт: одна команда на строку, пустые строки и строки с # пропускаются.
+// Список сохраняется после каждых save_every изменений (0 - только в конце)
+BatchStats RunBatch(task::TaskManager& manager, std::string_view script, size_t save_every,
+                    task::OutputBuffer& out, std::ostream& err);
+
+}  // namespace cli
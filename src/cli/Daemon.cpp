@@ -0,0 +1,375 @@
+#include "Daemon.hpp"
+
+#include "Batch.hpp"
+#include "Executor.hpp"
+#include "Parser.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <sys/time.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace cli {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Lock-free atomic можно менять из обработчика сигнала
+std::atomic<bool> stop_requested = false;
+
+void HandleStopSignal(int) { stop_requested = true; }
+
+std::runtime_error SystemError(std::string_view what) {
+    const std::error_code ec(errno, std::generic_category());
+    return std::runtime_error(std::format("{}: {}", what, ec.message()));
+}
+
+sockaddr_un MakeAddress(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument(std::format("Socket path is too long: {}", socket_path));
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    return address;
+}
+
+bool Connect(int fd, const sockaddr_un& address) {
+    return ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+void SetTimeout(int fd, std::chrono::milliseconds timeout) {
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000);
+    if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0) {
+        throw SystemError("Failed to set socket timeout");
+    }
+}
+
+void SendAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                throw std::runtime_error("Timed out sending data");
+            }
+            throw SystemError("Failed to send data");
+        }
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+}
+
+void ReceiveAll(int fd, std::string& data) {
+    data.clear();
+    char chunk[16 * 1024];
+    while (true) {
+        const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                throw std::runtime_error("Timed out receiving data");
+            }
+            throw SystemError("Failed to receive data");
+        }
+        if (received == 0) {
+            return;
+        }
+        data.append(chunk, static_cast<size_t>(received));
+    }
+}
+
+void WriteFd(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw SystemError("Failed to write output");
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+// Закрывает дескриптор при выходе из области видимости
+class FdGuard {
+ public:
+    explicit FdGuard(int fd) : fd_(fd) {}
+    ~FdGuard() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+    FdGuard(const FdGuard&) = delete;
+    FdGuard& operator=(const FdGuard&) = delete;
+
+    int Get() const { return fd_; }
+
+ private:
+    int fd_;
+};
+
+}  // namespace
+
+std::string DefaultSocketPath() { return task::DEFAULT_CONFIG_DIR + "/" + DEFAULT_SOCKET_NAME; }
+
+bool IsDaemonRunning(const std::string& socket_path) {
+    if (!fs::exists(socket_path)) {
+        return false;
+    }
+    FdGuard probe(::socket(AF_UNIX, SOCK_STREAM, 0));
+    return probe.Get() >= 0 && Connect(probe.Get(), MakeAddress(socket_path));
+}
+
+Daemon::Daemon(const std::string& config_path, const std::string& socket_path,
+               std::chrono::milliseconds client_timeout)
+    : socket_path_(socket_path), client_timeout_(client_timeout), manager_(config_path) {
+    RememberListTime();
+}
+
+Daemon::~Daemon() {
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        std::error_code ec;
+        fs::remove(socket_path_, ec);
+    }
+}
+
+void Daemon::Run() {
+    stop_requested = false;
+    Listen();
+
+    struct sigaction action{};
+    action.sa_handler = HandleStopSignal;
+    sigemptyset(&action.sa_mask);
+    // Без SA_RESTART, чтобы accept прерывался сигналом
+    action.sa_flags = 0;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::cout << std::format("Todo daemon is listening on {}", socket_path_) << std::endl;
+
+    while (!stop_requested) {
+        const int client_fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw SystemError("Failed to accept connection");
+        }
+
+        FdGuard client(client_fd);
+        if (stop_requested) {
+            break;
+        }
+        try {
+            // Клиент, который ничего не шлет, не должен задерживать остальных
+            SetTimeout(client.Get(), client_timeout_);
+            HandleClient(client.Get());
+        } catch (const std::exception& e) {
+            std::cerr << "Error in daemon: " << e.what() << '\n';
+        }
+    }
+
+    std::cout << "Todo daemon stopped" << std::endl;
+}
+
+void Daemon::Stop() {
+    stop_requested = true;
+    // Будим accept пустым подключением
+    FdGuard wake(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (wake.Get() >= 0) {
+        Connect(wake.Get(), MakeAddress(socket_path_));
+    }
+}
+
+void Daemon::Listen() {
+    const sockaddr_un address = MakeAddress(socket_path_);
+
+    // Оставшийся после сбоя файл сокета удаляем, работающий демон не трогаем
+    if (IsDaemonRunning(socket_path_)) {
+        throw std::runtime_error(std::format("Todo daemon is already running on {}", socket_path_));
+    }
+    if (fs::exists(socket_path_)) {
+        fs::remove(socket_path_);
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw SystemError("Failed to create socket");
+    }
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const std::runtime_error error = SystemError("Failed to bind " + socket_path_);
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        throw error;
+    }
+    if (::listen(listen_fd_, SOMAXCONN) != 0) {
+        throw SystemError("Failed to listen on " + socket_path_);
+    }
+}
+
+void Daemon::HandleClient(int client_fd) {
+    ReceiveAll(client_fd, request_);
+    // Пустое подключение - проверка IsDaemonRunning
+    if (request_.empty()) {
+        return;
+    }
+    SendAll(client_fd, Process(request_));
+}
+
+std::string Daemon::Process(std::string_view request) {
+    // Слова команды до пустого слова, дальше - данные для batch
+    args_.clear();
+    std::string_view payload;
+    while (!request.empty()) {
+        const size_t end = request.find('\0');
+        if (end == std::string_view::npos) {
+            break;
+        }
+        const std::string_view word = request.substr(0, end);
+        request.remove_prefix(end + 1);
+        if (word.empty()) {
+            payload = request;
+            break;
+        }
+        args_.push_back(word);
+    }
+
+    out_.Clear();
+    std::ostringstream err;
+    int status = 0;
+
+    try {
+        parser::Parser parser;
+        parser.Parse(args_);
+
+        ReloadIfChanged();
+        switch (parser.GetTypeCommand()) {
+            case parser::TypeCommand::DAEMON:
+                throw std::invalid_argument("Todo daemon is already running");
+            case parser::TypeCommand::BATCH: {
+                const BatchStats stats =
+                    RunBatch(manager_, payload, parser.GetSaveEvery(), out_, err);
+                status = stats.failed == 0 ? 0 : 1;
+                break;
+            }
+            default:
+                if (Executor(manager_).Execute(parser, out_)) {
+                    manager_.Save();
+                }
+                break;
+        }
+        RememberListTime();
+    } catch (const std::exception& e) {
+        err << e.what() << '\n';
+        status = 1;
+    }
+
+    const std::string& output = out_.GetData();
+    return std::format("{} {}\n", status, output.size()) + output + err.str();
+}
+
+void Daemon::ReloadIfChanged() {
+    // Файл мог изменить процесс, работавший без демона
+    const std::string& full_name = manager_.GetFullName();
+    std::error_code ec;
+    const fs::file_time_type time = fs::last_write_time(full_name, ec);
+    if ((ec ? fs::file_time_type::min() : time) != list_time_) {
+        manager_.LoadTasksFromFile(full_name);
+        list_time_ = ec ? fs::file_time_type::min() : time;
+    }
+}
+
+void Daemon::RememberListTime() {
+    std::error_code ec;
+    const fs::file_time_type time = fs::last_write_time(manager_.GetFullName(), ec);
+    list_time_ = ec ? fs::file_time_type::min() : time;
+}
+
+std::optional<int> ForwardToDaemon(const std::string& socket_path,
+                                   std::span<const std::string_view> args,
+                                   std::string_view payload,
+                                   std::chrono::milliseconds timeout) {
+    sockaddr_un address;
+    try {
+        address = MakeAddress(socket_path);
+    } catch (const std::invalid_argument&) {
+        return std::nullopt;
+    }
+
+    FdGuard socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (socket.Get() < 0) {
+        return std::nullopt;
+    }
+    // Остановленный или занятый демон не должен подвешивать каждый вызов todo
+    SetTimeout(socket.Get(), timeout);
+    if (!Connect(socket.Get(), address)) {
+        // Очередь подключений полна: демон жив, но не принимает их
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            throw std::runtime_error("Todo daemon is not accepting connections");
+        }
+        return std::nullopt;
+    }
+
+    std::string request;
+    for (const std::string_view arg : args) {
+        request.append(arg);
+        request.push_back('\0');
+    }
+    request.push_back('\0');
+    request.append(payload);
+
+    std::string response;
+    try {
+        SendAll(socket.Get(), request);
+        ::shutdown(socket.Get(), SHUT_WR);
+        ReceiveAll(socket.Get(), response);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(std::format(
+            "Todo daemon did not respond: {}. The command may have been applied", e.what()));
+    }
+
+    // Заголовок ответа: "<код> <размер stdout>\n"
+    const size_t header_end = response.find('\n');
+    if (header_end == std::string::npos) {
+        throw std::runtime_error("Invalid response from todo daemon");
+    }
+
+    int status = 1;
+    size_t output_size = 0;
+    const char* header = response.data();
+    const auto [status_end, status_ec] = std::from_chars(header, header + header_end, status);
+    if (status_ec != std::errc() || status_end == header + header_end ||
+        std::from_chars(status_end + 1, header + header_end, output_size).ec != std::errc() ||
+        output_size > response.size() - header_end - 1) {
+        throw std::runtime_error("Invalid response from todo daemon");
+    }
+
+    const std::string_view body = std::string_view(response).substr(header_end + 1);
+    WriteFd(STDOUT_FILENO, body.substr(0, output_size));
+    WriteFd(STDERR_FILENO, body.substr(output_size));
+    return status;
+}
+
+}  // namespace cli
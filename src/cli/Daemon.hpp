@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Output.hpp"
+#include "Task.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cli {
+
+const std::string DEFAULT_SOCKET_NAME = "todo.sock";
+
+std::string DefaultSocketPath();
+
+bool IsDaemonRunning(const std::string& socket_path);
+
+// Резидентный процесс: держит список задач в памяти и выполняет команды,
+// присланные клиентами через Unix-сокет.
+//
+// Запрос: слова команды, каждое завершается '\0', затем пустое слово и
+// данные для batch до конца соединения.
+// Ответ: строка "<код> <размер stdout>\n", затем stdout и stderr команды
+class Daemon {
+ public:
+    // Сколько ждать запроса или чтения ответа от одного клиента
+    static constexpr std::chrono::milliseconds DEFAULT_CLIENT_TIMEOUT{5000};
+
+    Daemon(const std::string& config_path, const std::string& socket_path,
+           std::chrono::milliseconds client_timeout = DEFAULT_CLIENT_TIMEOUT);
+    ~Daemon();
+
+    Daemon(const Daemon&) = delete;
+    Daemon& operator=(const Daemon&) = delete;
+
+    // Обслуживает клиентов до SIGINT или SIGTERM
+    void Run();
+    // Завершает Run из другого потока
+    void Stop();
+
+ private:
+    std::string socket_path_;
+    std::chrono::milliseconds client_timeout_;
+    task::TaskManager manager_;
+    std::filesystem::file_time_type list_time_;
+    int listen_fd_ = -1;
+
+    std::string request_;
+    std::vector<std::string_view> args_;
+    task::OutputBuffer out_{task::OutputBuffer::NO_FD};
+
+    void Listen();
+    void HandleClient(int client_fd);
+    std::string Process(std::string_view request);
+    void ReloadIfChanged();
+    void RememberListTime();
+};
+
+// Сколько клиент ждет демона при каждой отправке и чтении ответа
+inline constexpr std::chrono::milliseconds DEFAULT_FORWARD_TIMEOUT{10000};
+
+// Передает команду запущенному демону и печатает ответ.
+// Возвращает код завершения или nullopt, если демон не запущен.
+// Если демон не ответил за timeout, бросает исключение: команду нельзя
+// выполнить локально, ведь демон мог ее уже применить
+std::optional<int> ForwardToDaemon(const std::string& socket_path,
+                                   std::span<const std::string_view> args,
+                                   std::string_view payload = {},
+                                   std::chrono::milliseconds timeout = DEFAULT_FORWARD_TIMEOUT);
+
+}  // namespace cli
@@ -0,0 +1,166 @@
+#include "Executor.hpp"
+
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+namespace cli {
+
+using namespace std::string_literals;
+using parser::ConfigOption;
+using parser::ListOption;
+using parser::TypeCommand;
+using CommandOption = parser::Parser::CommandOption;
+
+void PrintHelp(task::OutputBuffer& out) {
+    out.Write("Todo List Manager\n");
+    out.Write("Usage: todo [command] [arguments]\n\n");
+    out.Write("Commands:\n");
+    out.Write("  add <text>          Add a new task\n");
+    out.Write("  list                Show all tasks\n");
+    out.Write("  list pending        Show pending tasks\n");
+    out.Write("  list completed      Show completed tasks\n");
+    out.Write("  list --format=<fmt> Output format: plain, json or ndjson\n");
+    out.Write("  list --from N --count M  Show M tasks starting from position N\n");
+    out.Write("  clear               Clear all tasks\n");
+    out.Write("  done <indices>      Toggle task completion status, e.g. done 1-5,9\n");
+    out.Write("  remove <indices>    Remove tasks, e.g. remove 3 9 40-60\n");
+    out.Write("  edit <index> <text> Edit a task\n");
+    out.Write("  config path <path>  Set the path for task files\n");
+    out.Write("  config name <name>  Set the filename for task list\n");
+    out.Write("  batch [file|-]      Run commands from a file or stdin, one per line\n");
+    out.Write("    --save-every N    Save the list after every N changes\n");
+    out.Write("  daemon              Keep the list in memory and serve other todo calls\n");
+    out.Write("  shell               Interactive mode, exit with 'exit' or Ctrl-D\n");
+    out.Write("  help                Show this help message\n");
+}
+
+Executor::Executor(task::TaskManager& manager) : manager_(manager) {}
+
+bool Executor::Execute(const parser::Parser& parser, task::OutputBuffer& out) {
+    const TypeCommand type_command = parser.GetTypeCommand();
+    switch (type_command) {
+        case TypeCommand::HELP:
+            PrintHelp(out);
+            return false;
+        case TypeCommand::ADD:
+            manager_.AddTask(parser.GetTaskText());
+            out.Write("Task added successfully.\n");
+            return true;
+        case TypeCommand::LIST: {
+            const task::OutputFormat format = parser.GetOutputFormat();
+            const task::ListRange& range = parser.GetListRange();
+
+            std::optional<bool> only_completed = std::nullopt;
+            const CommandOption command_option = parser.GetCommandOption();
+            if (auto pList = std::get_if<ListOption>(&command_option)) {
+                const auto& list_option = *pList;
+                switch (list_option) {
+                    case ListOption::PENDING:
+                        only_completed = false;
+                        break;
+                    case ListOption::COMPLETED:
+                        only_completed = true;
+                        break;
+                }
+            }
+
+            const size_t shown = manager_.PrintTasks(out, only_completed, range, format);
+            if (format == task::OutputFormat::PLAIN && !range.IsFull() && shown > 0) {
+                out.Print("Shown {}-{} of {} tasks\n", range.from, range.from + shown - 1,
+                          manager_.CountTasks(only_completed));
+            }
+            return false;
+        }
+        case TypeCommand::CLEAR:
+            manager_.ClearTasks();
+            out.Print("All tasks in {} cleared successfully\n", manager_.GetFullName());
+            return true;
+        case TypeCommand::DONE: {
+            const std::span<const size_t> indices = GetExistingIndices(parser);
+            manager_.ToggleTasks(indices);
+            if (indices.size() == 1) {
+                out.Print("Task with index {} toggled successfully\n", indices.front());
+            } else {
+                out.Print("{} tasks toggled successfully\n", indices.size());
+            }
+            return true;
+        }
+        case TypeCommand::REMOVE: {
+            const std::span<const size_t> indices = GetExistingIndices(parser);
+            manager_.RemoveTasks(indices);
+            if (indices.size() == 1) {
+                out.Print("Task with index {} removed successfully\n", indices.front());
+            } else {
+                out.Print("{} tasks removed successfully\n", indices.size());
+            }
+            return true;
+        }
+        case TypeCommand::EDIT: {
+            const size_t index = GetExistingIndex(parser);
+            manager_.EditTask(index, parser.GetTaskText());
+            out.Print("Task with index {} edited successfully\n", index);
+            return true;
+        }
+        case TypeCommand::CONFIG: {
+            const std::string& config_path = manager_.GetConfigPath();
+            const CommandOption command_option = parser.GetCommandOption();
+            if (auto pConfig = std::get_if<ConfigOption>(&command_option)) {
+                const auto& config_option = *pConfig;
+                switch (config_option) {
+                    // TODO: Решить как и что проверять для параметра пути и имени
+                    case ConfigOption::PATH:
+                        task::TaskManager::SetPath(std::string(parser.GetTaskText()), config_path);
+                        out.Write("Path updated successfully.\n");
+                        break;
+                    case ConfigOption::NAME:
+                        task::TaskManager::SetName(std::string(parser.GetTaskText()), config_path);
+                        out.Write("Filename updated successfully.\n");
+                        break;
+                }
+            }
+            // В batch, shell и демоне список остается в памяти: дальше работаем
+            // с файлом из новой конфигурации
+            manager_.ReloadConfig();
+            return false;
+        }
+        default:
+            throw std::invalid_argument("Command is not supported here"s);
+    }
+}
+
+std::span<const size_t> Executor::GetExistingIndices(const parser::Parser& parser) const {
+    const std::span<const size_t> indices = parser.GetTaskIndices();
+    if (indices.empty()) {
+        throw std::runtime_error("Task index was not specified"s);
+    }
+
+    // Номера отсортированы: достаточно найти первый несуществующий
+    const auto missing =
+        std::lower_bound(indices.begin(), indices.end(), manager_.GetTasks().size());
+    if (missing != indices.end()) {
+        const std::string message = std::format("Task with index {} does not exist", *missing);
+        throw std::runtime_error(message);
+    }
+    return indices;
+}
+
+size_t Executor::GetExistingIndex(const parser::Parser& parser) const {
+    const std::optional<size_t> index_opt = parser.GetTaskIndex();
+    if (index_opt == std::nullopt) {
+        throw std::runtime_error("Task index was not specified"s);
+    }
+
+    const size_t index = index_opt.value();
+    if (!manager_.TaskExists(index)) {
+        const std::string message = std::format("Task with index {} does not exist", index);
+        throw std::runtime_error(message);
+    }
+    return index;
+}
+
+}  // namespace cli
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Output.hpp"
+#include "Parser.hpp"
+#include "Task.hpp"
+
+namespace cli {
+
+void PrintHelp(task::OutputBuffer& out);
+
+// Выполняет разобранную команду над списком задач.
+// Сохранение списка остается за вызывающим кодом
+class Executor {
+ public:
+    explicit Executor(task::TaskManager& manager);
+
+    // Возвращает true, если команда изменила список задач
+    bool Execute(const parser::Parser& parser, task::OutputBuffer& out);
+
+ private:
+    task::TaskManager& manager_;
+
+    size_t GetExistingIndex(const parser::Parser& parser) const;
+    std::span<const size_t> GetExistingIndices(const parser::Parser& parser) const;
+};
+
+}  // namespace cli
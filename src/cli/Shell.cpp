@@ -0,0 +1,472 @@
+#include "Shell.hpp"
+
+#include "Commands.hpp"
+#include "Executor.hpp"
+#include "Parser.hpp"
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+namespace cli {
+
+namespace {
+
+using Completer = std::function<std::vector<std::string>(std::string_view)>;
+
+enum class ReadStatus { LINE, TIMEOUT, END };
+
+constexpr size_t MAX_COMPLETIONS = 1000;
+constexpr size_t MAX_SHOWN_COMPLETIONS = 100;
+
+const std::string PROMPT = "todo> ";
+
+bool IsExitCommand(std::string_view word) {
+    return parser::EqualsIgnoreCase(word, "exit") ||
+           parser::EqualsIgnoreCase(word, "quit");
+}
+
+void WriteAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+// Построчное чтение с ожиданием по таймауту. В терминале включает
+// неканонический режим с простым редактированием строки и дополнением по Tab
+class LineReader {
+ public:
+    explicit LineReader(int fd) : fd_(fd) {
+        if (::isatty(fd_) && ::tcgetattr(fd_, &saved_) == 0) {
+            termios raw = saved_;
+            raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            terminal_ = ::tcsetattr(fd_, TCSAFLUSH, &raw) == 0;
+        }
+    }
+
+    ~LineReader() {
+        if (terminal_) {
+            ::tcsetattr(fd_, TCSAFLUSH, &saved_);
+        }
+    }
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    ReadStatus ReadLine(std::string& line, std::optional<std::chrono::milliseconds> timeout,
+                        const Completer& complete) {
+        return terminal_ ? ReadTerminalLine(line, timeout, complete) : ReadPlainLine(line, timeout);
+    }
+
+ private:
+    int fd_;
+    bool terminal_ = false;
+    termios saved_{};
+
+    std::string pending_;
+    std::string edited_;
+    bool prompt_shown_ = false;
+    bool escape_ = false;
+    bool eof_ = false;
+
+    // Возвращает false, если за timeout ввод не появился
+    bool WaitInput(std::optional<std::chrono::milliseconds> timeout) {
+        pollfd descriptor{fd_, POLLIN, 0};
+        const int wait_ms = timeout ? static_cast<int>(timeout->count()) : -1;
+        while (true) {
+            const int ready = ::poll(&descriptor, 1, wait_ms);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            return ready != 0;
+        }
+    }
+
+    bool FillPending() {
+        char chunk[4096];
+        while (true) {
+            const ssize_t received = ::read(fd_, chunk, sizeof(chunk));
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                eof_ = true;
+                return false;
+            }
+            pending_.append(chunk, static_cast<size_t>(received));
+            return true;
+        }
+    }
+
+    ReadStatus ReadPlainLine(std::string& line, std::optional<std::chrono::milliseconds> timeout) {
+        while (true) {
+            const size_t end = pending_.find('\n');
+            if (end != std::string::npos) {
+                line.assign(pending_, 0, end);
+                pending_.erase(0, end + 1);
+                return ReadStatus::LINE;
+            }
+            if (eof_) {
+                if (pending_.empty()) {
+                    return ReadStatus::END;
+                }
+                line = std::move(pending_);
+                pending_.clear();
+                return ReadStatus::LINE;
+            }
+            if (!WaitInput(timeout)) {
+                return ReadStatus::TIMEOUT;
+            }
+            FillPending();
+        }
+    }
+
+    void Redraw() { WriteAll(STDOUT_FILENO, "\r\x1b[K" + PROMPT + edited_); }
+
+    void EraseLastChar() {
+        // Удаляем последний символ UTF-8 целиком
+        while (!edited_.empty()) {
+            const unsigned char c = static_cast<unsigned char>(edited_.back());
+            edited_.pop_back();
+            if ((c & 0xC0) != 0x80) {
+                break;
+            }
+        }
+    }
+
+    void CompleteWord(const Completer& complete) {
+        const std::vector<std::string> candidates = complete(edited_);
+        if (candidates.empty()) {
+            WriteAll(STDOUT_FILENO, "\a");
+            return;
+        }
+
+        const size_t word_start = edited_.find_last_of(" \t") == std::string::npos
+                                      ? 0
+                                      : edited_.find_last_of(" \t") + 1;
+        const size_t typed = edited_.size() - word_start;
+
+        // Общий префикс всех вариантов
+        size_t common = candidates.front().size();
+        for (const std::string& candidate : candidates) {
+            const auto [mismatch, _] =
+                std::mismatch(candidates.front().begin(), candidates.front().begin() + common,
+                              candidate.begin(), candidate.end());
+            common = static_cast<size_t>(mismatch - candidates.front().begin());
+        }
+
+        if (common > typed) {
+            edited_.append(candidates.front(), typed, common - typed);
+        }
+        if (candidates.size() == 1) {
+            edited_.push_back(' ');
+        } else if (common <= typed) {
+            std::string shown = "\n";
+            for (size_t i = 0; i < candidates.size() && i < MAX_SHOWN_COMPLETIONS; ++i) {
+                shown += candidates[i];
+                shown += ' ';
+            }
+            if (candidates.size() > MAX_SHOWN_COMPLETIONS) {
+                shown += "...";
+            }
+            shown += "\n";
+            WriteAll(STDOUT_FILENO, shown);
+        }
+        Redraw();
+    }
+
+    ReadStatus ReadTerminalLine(std::string& line,
+                                std::optional<std::chrono::milliseconds> timeout,
+                                const Completer& complete) {
+        if (!prompt_shown_) {
+            Redraw();
+            prompt_shown_ = true;
+        }
+
+        while (true) {
+            if (pending_.empty()) {
+                if (eof_) {
+                    return ReadStatus::END;
+                }
+                if (!WaitInput(timeout)) {
+                    return ReadStatus::TIMEOUT;
+                }
+                if (!FillPending()) {
+                    return ReadStatus::END;
+                }
+            }
+
+            size_t consumed = 0;
+            while (consumed < pending_.size()) {
+                const char c = pending_[consumed++];
+
+                // Пропускаем escape-последовательности (стрелки и т.п.)
+                if (escape_) {
+                    escape_ = c == '[' || c == 'O' || !(c >= 0x40 && c <= 0x7E);
+                    continue;
+                }
+
+                switch (c) {
+                    case '\r':
+                    case '\n':
+                        pending_.erase(0, consumed);
+                        WriteAll(STDOUT_FILENO, "\n");
+                        line = std::move(edited_);
+                        edited_.clear();
+                        prompt_shown_ = false;
+                        return ReadStatus::LINE;
+                    case 4:  // Ctrl-D
+                        if (edited_.empty()) {
+                            pending_.erase(0, consumed);
+                            WriteAll(STDOUT_FILENO, "\n");
+                            return ReadStatus::END;
+                        }
+                        break;
+                    case 3:  // Ctrl-C
+                        WriteAll(STDOUT_FILENO, "^C\n");
+                        edited_.clear();
+                        Redraw();
+                        break;
+                    case 21:  // Ctrl-U
+                        edited_.clear();
+                        Redraw();
+                        break;
+                    case 127:
+                    case '\b':
+                        EraseLastChar();
+                        Redraw();
+                        break;
+                    case '\t':
+                        CompleteWord(complete);
+                        break;
+                    case 27:
+                        escape_ = true;
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) >= 0x20) {
+                            edited_.push_back(c);
+                            WriteAll(STDOUT_FILENO, std::string_view(&c, 1));
+                        }
+                        break;
+                }
+            }
+            pending_.clear();
+        }
+    }
+};
+
+}  // namespace
+
+Shell::Shell(task::TaskManager& manager, std::chrono::milliseconds save_delay,
+             std::chrono::milliseconds save_max_delay)
+    : manager_(manager), save_delay_(save_delay), save_max_delay_(save_max_delay) {}
+
+Shell::~Shell() {
+    try {
+        SaveIfDirty();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+void Shell::Run() {
+    LineReader reader(STDIN_FILENO);
+    task::OutputBuffer out;
+    const Completer complete = [this](std::string_view line) { return Complete(line); };
+
+    std::string line;
+    while (true) {
+        out.Flush();
+
+        const ReadStatus status = reader.ReadLine(line, TimeUntilSave(), complete);
+        if (status == ReadStatus::END) {
+            break;
+        }
+        // Ошибка команды или сохранения не завершает сеанс: список остается в памяти
+        try {
+            if (status == ReadStatus::LINE && !ExecuteLine(line, out)) {
+                break;
+            }
+            SaveIfDue();
+        } catch (const std::exception& e) {
+            out.Flush();
+            std::cerr << e.what() << '\n';
+        }
+    }
+
+    out.Flush();
+    SaveIfDirty();
+}
+
+bool Shell::ExecuteLine(std::string_view line, task::OutputBuffer& out) {
+    parser::SplitWords(line, words_);
+    if (words_.empty()) {
+        return true;
+    }
+    if (IsExitCommand(words_.front())) {
+        return false;
+    }
+
+    parser::Parser command_parser;
+    command_parser.Parse(words_);
+    switch (command_parser.GetTypeCommand()) {
+        case parser::TypeCommand::BATCH:
+        case parser::TypeCommand::DAEMON:
+        case parser::TypeCommand::SHELL:
+            throw std::invalid_argument("This command is not available in shell");
+        case parser::TypeCommand::CONFIG:
+            // После config менеджер откроет другой список - сохраняем текущий
+            SaveIfDirty();
+            break;
+        default:
+            break;
+    }
+
+    if (Executor(manager_).Execute(command_parser, out)) {
+        MarkDirty();
+    }
+    return true;
+}
+
+std::vector<std::string> Shell::Complete(std::string_view line) const {
+    std::vector<std::string> candidates;
+
+    std::vector<std::string_view> words;
+    try {
+        parser::SplitWords(line, words);
+    } catch (const std::invalid_argument&) {
+        return candidates;
+    }
+
+    const bool new_word = line.empty() || std::isspace(static_cast<unsigned char>(line.back()));
+    const std::string_view prefix = new_word ? std::string_view{} : words.back();
+    const size_t position = new_word ? words.size() : words.size() - 1;
+
+    auto add_if_matches = [&](std::string_view candidate) {
+        if (candidate.starts_with(prefix)) {
+            candidates.emplace_back(candidate);
+        }
+    };
+
+    if (position == 0) {
+        for (const parser::CommandInfo& command : parser::COMMANDS) {
+            if ((command.scope & parser::CLI) != 0 && command.type != parser::TypeCommand::BATCH &&
+                command.type != parser::TypeCommand::DAEMON &&
+                command.type != parser::TypeCommand::SHELL) {
+                add_if_matches(command.name);
+            }
+        }
+        add_if_matches("exit");
+        return candidates;
+    }
+
+    const parser::CommandInfo* command = parser::FindCommand(words.front(), parser::CLI);
+    if (command == nullptr) {
+        return candidates;
+    }
+
+    switch (command->type) {
+        case parser::TypeCommand::DONE:
+        case parser::TypeCommand::REMOVE:
+        case parser::TypeCommand::EDIT: {
+            if (position != 1) {
+                break;
+            }
+            // Номера существующих задач, начинающиеся с набранных цифр
+            char number[24];
+            const size_t count = manager_.CountTasks();
+            for (size_t i = 0; i < count && candidates.size() < MAX_COMPLETIONS; ++i) {
+                const auto [end, _] = std::to_chars(number, number + sizeof(number), i);
+                add_if_matches(std::string_view(number, static_cast<size_t>(end - number)));
+            }
+            break;
+        }
+        case parser::TypeCommand::LIST:
+            for (const std::string_view option :
+                 {"pending", "completed", "--format=plain", "--format=json", "--format=ndjson",
+                  "--from", "--count"}) {
+                add_if_matches(option);
+            }
+            break;
+        case parser::TypeCommand::CONFIG:
+            if (position == 1) {
+                add_if_matches("path");
+                add_if_matches("name");
+            }
+            break;
+        default:
+            break;
+    }
+
+    return candidates;
+}
+
+void Shell::SaveIfDirty() {
+    if (!dirty_since_) {
+        return;
+    }
+    manager_.Save();
+    dirty_since_.reset();
+}
+
+std::optional<std::chrono::milliseconds> Shell::TimeUntilSave() const {
+    if (!dirty_since_) {
+        return std::nullopt;
+    }
+
+    Clock::time_point deadline =
+        std::min(last_change_ + save_delay_, *dirty_since_ + save_max_delay_);
+    if (retry_at_) {
+        deadline = std::max(deadline, *retry_at_);
+    }
+    const auto left =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+    return std::max(left, std::chrono::milliseconds::zero());
+}
+
+void Shell::SaveIfDue() {
+    const std::optional<std::chrono::milliseconds> left = TimeUntilSave();
+    if (!left || left->count() != 0) {
+        return;
+    }
+
+    try {
+        SaveIfDirty();
+    } catch (const std::exception&) {
+        // Причина (нет места, нет прав) обычно не исчезает сразу, поэтому
+        // повторяем с растущей паузой, а не при каждом таймауте ввода
+        retry_delay_ = retry_delay_.count() == 0
+                           ? SAVE_RETRY_DELAY
+                           : std::min(retry_delay_ * 2, SAVE_MAX_RETRY_DELAY);
+        retry_at_ = Clock::now() + retry_delay_;
+        throw;
+    }
+    retry_at_.reset();
+    retry_delay_ = std::chrono::milliseconds::zero();
+}
+
+void Shell::MarkDirty() {
+    last_change_ = Clock::now();
+    if (!dirty_since_) {
+        dirty_since_ = last_change_;
+    }
+}
+
+}  // namespace cli
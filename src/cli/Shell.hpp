@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Output.hpp"
+#include "Task.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cli {
+
+// Интерактивный режим: список загружается один раз, команды вводятся построчно.
+// Изменения сохраняются через save_delay после последней правки (но не позже
+// save_max_delay после первой несохраненной) и при выходе
+class Shell {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds DEFAULT_SAVE_DELAY{2000};
+    static constexpr std::chrono::milliseconds DEFAULT_SAVE_MAX_DELAY{10000};
+    // Пауза перед повтором неудачного сохранения удваивается от первой до последней
+    static constexpr std::chrono::milliseconds SAVE_RETRY_DELAY{1000};
+    static constexpr std::chrono::milliseconds SAVE_MAX_RETRY_DELAY{60000};
+
+    explicit Shell(task::TaskManager& manager,
+                   std::chrono::milliseconds save_delay = DEFAULT_SAVE_DELAY,
+                   std::chrono::milliseconds save_max_delay = DEFAULT_SAVE_MAX_DELAY);
+    ~Shell();
+
+    Shell(const Shell&) = delete;
+    Shell& operator=(const Shell&) = delete;
+
+    // Читает команды из стандартного ввода до exit, quit или конца ввода
+    void Run();
+
+    // Выполняет одну строку. Возвращает false для команды выхода
+    bool ExecuteLine(std::string_view line, task::OutputBuffer& out);
+
+    // Варианты дополнения последнего слова строки
+    std::vector<std::string> Complete(std::string_view line) const;
+
+    bool IsDirty() const { return dirty_since_.has_value(); }
+    void SaveIfDirty();
+
+ private:
+    task::TaskManager& manager_;
+    std::chrono::milliseconds save_delay_;
+    std::chrono::milliseconds save_max_delay_;
+
+    std::optional<Clock::time_point> dirty_since_;
+    Clock::time_point last_change_;
+    // После неудачного сохранения следующее не раньше этого времени
+    std::optional<Clock::time_point> retry_at_;
+    std::chrono::milliseconds retry_delay_{0};
+
+    std::vector<std::string_view> words_;
+
+    // Сколько ждать ввода до следующего сохранения (nullopt - без ограничения)
+    std::optional<std::chrono::milliseconds> TimeUntilSave() const;
+    // Ошибка сохранения бросается, а повтор откладывается
+    void SaveIfDue();
+    void MarkDirty();
+};
+
+}  // namespace cli
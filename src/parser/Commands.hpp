@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace parser {
+
+enum class TypeCommand { ADD, LIST, CLEAR, DONE, REMOVE, EDIT, HELP, CONFIG, START, BATCH, DAEMON, SHELL };
+
+// Число значений TypeCommand, для таблиц, индексируемых типом команды
+inline constexpr size_t COMMAND_TYPE_COUNT = static_cast<size_t>(TypeCommand::SHELL) + 1;
+
+// Где доступна команда: в CLI утилите, в Telegram боте или в обоих
+enum CommandScope : unsigned { CLI = 1u << 0, BOT = 1u << 1 };
+
+struct CommandInfo {
+    std::string_view name;
+    TypeCommand type;
+    unsigned scope;
+};
+
+// Единая таблица команд. Новая команда добавляется одной строкой
+inline constexpr std::array COMMANDS = {
+    CommandInfo{"add", TypeCommand::ADD, CLI | BOT},
+    CommandInfo{"list", TypeCommand::LIST, CLI | BOT},
+    CommandInfo{"clear", TypeCommand::CLEAR, CLI | BOT},
+    CommandInfo{"done", TypeCommand::DONE, CLI | BOT},
+    CommandInfo{"remove", TypeCommand::REMOVE, CLI | BOT},
+    CommandInfo{"edit", TypeCommand::EDIT, CLI},
+    CommandInfo{"help", TypeCommand::HELP, CLI | BOT},
+    CommandInfo{"config", TypeCommand::CONFIG, CLI},
+    CommandInfo{"start", TypeCommand::START, BOT},
+    CommandInfo{"batch", TypeCommand::BATCH, CLI},
+    CommandInfo{"daemon", TypeCommand::DAEMON, CLI},
+    CommandInfo{"shell", TypeCommand::SHELL, CLI},
+};
+
+// Сравнение ASCII строк без учета регистра, без временных копий
+constexpr char ToLowerAscii(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+constexpr bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (ToLowerAscii(lhs[i]) != ToLowerAscii(rhs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace detail {
+
+// FNV-1a без учета регистра с подбираемым начальным значением
+constexpr uint32_t HashCommand(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(ToLowerAscii(c));
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+inline constexpr size_t COMMAND_SLOTS = 32;
+static_assert((COMMAND_SLOTS & (COMMAND_SLOTS - 1)) == 0, "COMMAND_SLOTS must be a power of two");
+static_assert(COMMANDS.size() <= COMMAND_SLOTS, "Too many commands for the hash table");
+
+constexpr size_t CommandSlot(std::string_view name, uint32_t seed) {
+    return HashCommand(name, seed) & (COMMAND_SLOTS - 1);
+}
+
+// Подбираем seed, при котором все команды попадают в разные ячейки
+consteval uint32_t FindCommandSeed() {
+    for (uint32_t seed = 0; seed < 100000; ++seed) {
+        std::array<bool, COMMAND_SLOTS> used{};
+        bool perfect = true;
+        for (const CommandInfo& command : COMMANDS) {
+            const size_t slot = CommandSlot(command.name, seed);
+            if (used[slot]) {
+                perfect = false;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (perfect) {
+            return seed;
+        }
+    }
+    throw "Perfect hash seed for command table not found";
+}
+
+inline constexpr uint32_t COMMAND_SEED = FindCommandSeed();
+
+consteval std::array<int8_t, COMMAND_SLOTS> BuildCommandSlots() {
+    std::array<int8_t, COMMAND_SLOTS> slots{};
+    slots.fill(-1);
+    for (size_t i = 0; i < COMMANDS.size(); ++i) {
+        slots[CommandSlot(COMMANDS[i].name, COMMAND_SEED)] = static_cast<int8_t>(i);
+    }
+    return slots;
+}
+
+inline constexpr std::array<int8_t, COMMAND_SLOTS> COMMAND_INDEX = BuildCommandSlots();
+
+}  // namespace detail
+
+// Поиск команды по имени без учета регистра: одно вычисление хэша и одно сравнение
+constexpr const CommandInfo* FindCommand(std::string_view name, unsigned scope = CLI | BOT) {
+    const int8_t index = detail::COMMAND_INDEX[detail::CommandSlot(name, detail::COMMAND_SEED)];
+    if (index < 0) {
+        return nullptr;
+    }
+
+    const CommandInfo& command = COMMANDS[static_cast<size_t>(index)];
+    if (!EqualsIgnoreCase(command.name, name) || (command.scope & scope) == 0) {
+        return nullptr;
+    }
+    return &command;
+}
+
+static_assert(FindCommand("list") != nullptr && FindCommand("LIST")->type == TypeCommand::LIST);
+static_assert(FindCommand("start", CLI) == nullptr);
+
+}  // namespace parser
@@ -1,5 +1,7 @@
 #include "Parser.hpp"
 
+#include "Trace.hpp"
+
 #include <algorithm>
 #include <cctype>
 #include <charconv>
@@ -7,22 +9,16 @@
 #include <locale>
 #include <ranges>
 #include <stdexcept>
-#include <unordered_map>
+#include <string_view>
 
 namespace parser {
 
-// TODO: re-write on magic_enum
-TypeCommand CommandToEnum(const std::string& type) {
-    std::unordered_map<std::string, TypeCommand> commands = {
-        {"add", TypeCommand::ADD},   {"list", TypeCommand::LIST},     {"clear", TypeCommand::CLEAR},
-        {"done", TypeCommand::DONE}, {"remove", TypeCommand::REMOVE}, {"edit", TypeCommand::EDIT},
-        {"help", TypeCommand::HELP}, {"config", TypeCommand::CONFIG}};
-
-    if (commands.contains(type)) {
-        return commands[type];
-    } else {
+TypeCommand CommandToEnum(std::string_view type) {
+    const CommandInfo* command = FindCommand(type, CLI);
+    if (command == nullptr) {
         throw std::invalid_argument(std::format("Unknown command: {}", type));
     }
+    return command->type;
 }
 
 bool IsValidCommandWords(const TypeCommand& command, int count) {
@@ -32,7 +28,7 @@ bool IsValidCommandWords(const TypeCommand& command, int count) {
             break;
         case TypeCommand::DONE:
         case TypeCommand::REMOVE:
-            return count != 3 ? false : true;
+            return count < 3 ? false : true;
             break;
         case TypeCommand::EDIT:
             return count < 4 ? false : true;
@@ -47,15 +43,27 @@ bool IsValidCommandWords(const TypeCommand& command, int count) {
             return count != 2 ? false : true;
             break;
         case TypeCommand::CLEAR:
+        case TypeCommand::DAEMON:
+        case TypeCommand::SHELL:
             return count != 2 ? false : true;
             break;
+        case TypeCommand::BATCH:
+            return count < 2 || count > 3 ? false : true;
+            break;
         default:
             return false;
             break;
     }
 }
 
-size_t WordToNumber(const std::string& word) {
+int FlagWidth(std::string_view word) {
+    if (!word.starts_with("--")) {
+        return 0;
+    }
+    return word.find('=') == std::string_view::npos ? 2 : 1;
+}
+
+size_t WordToNumber(std::string_view word) {
     if (word.empty() || !std::all_of(word.begin(), word.end(), ::isdigit)) {
         throw std::invalid_argument(std::format("Word ({}) contains non-digit characters", word));
     }
@@ -70,6 +78,58 @@ size_t WordToNumber(const std::string& word) {
     return number;
 }
 
+namespace {
+
+void AppendIndexRange(size_t first, size_t last, std::vector<size_t>& indices) {
+    if (first > last) {
+        throw std::invalid_argument(std::format("Invalid index range - {}-{}", first, last));
+    }
+    if (last - first >= MAX_TASK_INDICES - indices.size()) {
+        throw std::invalid_argument(
+            std::format("Too many task indices (maximum {})", MAX_TASK_INDICES));
+    }
+    for (size_t index = first; index <= last; ++index) {
+        indices.push_back(index);
+    }
+}
+
+}  // namespace
+
+void ParseIndices(std::span<const std::string_view> words, std::vector<size_t>& indices) {
+    indices.clear();
+    for (std::string_view word : words) {
+        // Запятая на краю слова - разделитель рядом с пробелом: "1, 2", "1 ,2", "1 , 2"
+        if (word.starts_with(',')) {
+            word.remove_prefix(1);
+        }
+        if (word.ends_with(',')) {
+            word.remove_suffix(1);
+        }
+        if (word.empty()) {
+            continue;
+        }
+        for (const auto part : std::views::split(word, ',')) {
+            const std::string_view item(part.begin(), part.end());
+            const size_t dash = item.find('-');
+            if (dash == std::string_view::npos) {
+                const size_t index = WordToNumber(item);
+                AppendIndexRange(index, index, indices);
+            } else {
+                AppendIndexRange(WordToNumber(item.substr(0, dash)),
+                                 WordToNumber(item.substr(dash + 1)), indices);
+            }
+        }
+    }
+
+    if (indices.empty()) {
+        throw std::invalid_argument("Task index was not specified");
+    }
+
+    std::ranges::sort(indices);
+    const auto duplicates = std::ranges::unique(indices);
+    indices.erase(duplicates.begin(), duplicates.end());
+}
+
 std::string ToLower(const std::string& str) {
     auto to_lower = [](char c) { return std::tolower(c); };
 
@@ -81,39 +141,88 @@ std::string ToLower(const std::string& str) {
     return lower;
 }
 
+void SplitWords(std::string_view line, std::vector<std::string_view>& words) {
+    words.clear();
+
+    size_t pos = 0;
+    while (pos < line.size()) {
+        if (std::isspace(static_cast<unsigned char>(line[pos]))) {
+            ++pos;
+            continue;
+        }
+
+        const char quote = line[pos];
+        if (quote == '"' || quote == '\'') {
+            const size_t end = line.find(quote, pos + 1);
+            if (end == std::string_view::npos) {
+                throw std::invalid_argument(std::format("Unclosed quote in line: {}", line));
+            }
+            words.push_back(line.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+            continue;
+        }
+
+        size_t end = pos;
+        while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))) {
+            ++end;
+        }
+        words.push_back(line.substr(pos, end - pos));
+        pos = end;
+    }
+}
+
 void Parser::Parse(int& argc, char** argv) {
+    args_.clear();
+    for (int i = 1; i < argc; ++i) {
+        args_.emplace_back(argv[i]);
+    }
+    Parse(args_);
+}
+
+void Parser::Parse(std::span<const std::string_view> args) {
+    trace::Span span("parser", "Parser::Parse");
     command_ = Command{};
-    if (argc < 2) {
+    task_indices_.clear();
+    if (args.empty()) {
         return;
     }
 
-    const std::string type_str = ToLower(std::string(argv[1]));
+    const std::string_view type_str = args[0];
     const TypeCommand type = CommandToEnum(type_str);
 
-    if (!IsValidCommandWords(type, argc)) {
+    // Флаги (--name=value или --name value) не считаются словами команды.
+    // Количество слов считается вместе с именем программы, как argc
+    int words = static_cast<int>(args.size()) + 1;
+    if (type == TypeCommand::LIST || type == TypeCommand::BATCH) {
+        for (size_t i = 1; i < args.size(); ++i) {
+            const int width = FlagWidth(args[i]);
+            words -= width;
+            i += std::max(width - 1, 0);
+        }
+    }
+
+    if (!IsValidCommandWords(type, words)) {
         const std::string message =
             std::format("Invalid count of arguments for command - {}.", type_str);
         throw std::invalid_argument(message);
     }
 
+    command_.type = type;
     switch (type) {
         case TypeCommand::ADD: {
-            command_.type = type;
-            for (int i = 2; i < argc; ++i) {
-                if (i > 2) {
-                    command_.text += " ";
-                }
-                command_.text += argv[i];
-            }
+            AppendText(args.subspan(1));
             break;
         }
         case TypeCommand::LIST: {
-            command_.type = type;
-            if (argc == 3) {
-                std::string option_list = ToLower(std::string(argv[2]));
-                if (option_list == "pending") {
+            for (size_t i = 1; i < args.size(); ++i) {
+                if (const int width = ParseFlag(args, i); width > 0) {
+                    i += width - 1;
+                    continue;
+                }
+                const std::string_view option_list = args[i];
+                if (EqualsIgnoreCase(option_list, "pending")) {
                     command_.option = ListOption::PENDING;
-                } else if (option_list == "completed") {
+                } else if (EqualsIgnoreCase(option_list, "completed")) {
                     command_.option = ListOption::COMPLETED;
                 } else {
                     const std::string message =
@@ -124,47 +233,31 @@ void Parser::Parse(int& argc, char** argv) {
             break;
         }
         case TypeCommand::CLEAR: {
-            command_.type = type;
-            break;
-        }
-        case TypeCommand::DONE: {
-            command_.type = type;
-
-            size_t number = WordToNumber(argv[2]);
-            command_.task_index = number;
             break;
         }
+        case TypeCommand::DONE:
         case TypeCommand::REMOVE: {
-            command_.type = type;
-
-            size_t number = WordToNumber(argv[2]);
-            command_.task_index = number;
+            ParseIndices(args.subspan(1), task_indices_);
+            command_.task_index = task_indices_.front();
             break;
         }
         case TypeCommand::EDIT: {
-            command_.type = type;
-
-            size_t number = WordToNumber(argv[2]);
+            size_t number = WordToNumber(args[1]);
             command_.task_index = number;
 
-            for (int i = 3; i < argc; ++i) {
-                if (i > 3) {
-                    command_.text += " ";
-                }
-                command_.text += argv[i];
-            }
+            AppendText(args.subspan(2));
             break;
         }
-        case TypeCommand::HELP: {
-            command_.type = type;
+        case TypeCommand::HELP:
+        case TypeCommand::DAEMON:
+        case TypeCommand::SHELL: {
             break;
         }
         case TypeCommand::CONFIG: {
-            command_.type = type;
-            std::string option_config = ToLower(std::string(argv[2]));
-            if (option_config == "path") {
+            const std::string_view option_config = args[1];
+            if (EqualsIgnoreCase(option_config, "path")) {
                 command_.option = ConfigOption::PATH;
-            } else if (option_config == "name") {
+            } else if (EqualsIgnoreCase(option_config, "name")) {
                 command_.option = ConfigOption::NAME;
             } else {
                 const std::string message =
@@ -172,13 +265,19 @@ void Parser::Parse(int& argc, char** argv) {
                 throw std::invalid_argument(message);
             }
 
-            for (int i = 3; i < argc; ++i) {
-                if (i > 3) {
-                    command_.text += " ";
+            AppendText(args.subspan(2));
+            break;
+        }
+        case TypeCommand::BATCH: {
+            // По умолчанию команды читаются из стандартного ввода
+            command_.text = "-";
+            for (size_t i = 1; i < args.size(); ++i) {
+                if (const int width = ParseFlag(args, i); width > 0) {
+                    i += width - 1;
+                    continue;
                 }
-                command_.text += argv[i];
+                command_.text = args[i];
             }
-
             break;
         }
         default: {
@@ -188,4 +287,59 @@ void Parser::Parse(int& argc, char** argv) {
     }
 }
 
+void Parser::AppendText(std::span<const std::string_view> words) {
+    // Одно слово не копируется: текст указывает прямо на него
+    if (words.size() == 1) {
+        command_.text = words[0];
+        return;
+    }
+
+    size_t length = words.empty() ? 0 : words.size() - 1;
+    for (const std::string_view word : words) {
+        length += word.size();
+    }
+
+    text_buffer_.clear();
+    text_buffer_.reserve(length);
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (i > 0) {
+            text_buffer_ += ' ';
+        }
+        text_buffer_ += words[i];
+    }
+    command_.text_in_buffer = true;
+}
+
+int Parser::ParseFlag(std::span<const std::string_view> args, size_t index) {
+    const std::string_view flag = args[index];
+    const int width = FlagWidth(flag);
+    if (width == 0) {
+        return 0;
+    }
+
+    std::string_view value;
+    if (width == 1) {
+        value = flag.substr(flag.find('=') + 1);
+    } else if (index + 1 < args.size()) {
+        value = args[index + 1];
+    } else {
+        throw std::invalid_argument(std::format("Missing value for flag - {}", flag));
+    }
+
+    const std::string_view name = flag.substr(0, flag.find('='));
+    if (command_.type == TypeCommand::LIST && EqualsIgnoreCase(name, "--format")) {
+        command_.format = task::FormatFromString(value);
+    } else if (command_.type == TypeCommand::LIST && EqualsIgnoreCase(name, "--from")) {
+        command_.range.from = WordToNumber(value);
+    } else if (command_.type == TypeCommand::LIST && EqualsIgnoreCase(name, "--count")) {
+        command_.range.count = WordToNumber(value);
+    } else if (command_.type == TypeCommand::BATCH && EqualsIgnoreCase(name, "--save-every")) {
+        command_.save_every = WordToNumber(value);
+    } else {
+        throw std::invalid_argument(std::format("Unknown flag - {}", flag));
+    }
+
+    return width;
+}
+
 }  // namespace parser
@@ -1,26 +1,42 @@
 #pragma once
 
+#include "Commands.hpp"
+#include "Output.hpp"
+
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace parser {
 
-enum class TypeCommand { ADD, LIST, CLEAR, DONE, REMOVE, EDIT, HELP, CONFIG };
-
 enum class ListOption { PENDING, COMPLETED };
 
 enum class ConfigOption { PATH, NAME };
 
-TypeCommand CommandToEnum(const std::string& type);
+using task::OutputFormat;
+
+TypeCommand CommandToEnum(std::string_view type);
 
 bool IsValidCommandWords(const TypeCommand& command, int count);
 
-size_t WordToNumber(const std::string& word);
+int FlagWidth(std::string_view word);
+
+size_t WordToNumber(std::string_view word);
+
+inline constexpr size_t MAX_TASK_INDICES = 100000;
+
+// Разбирает номера задач вида "3", "1-500,712" в отсортированный список без повторов.
+// Номера разделяются запятой, пробелом или запятой с пробелами
+void ParseIndices(std::span<const std::string_view> words, std::vector<size_t>& indices);
 
 std::string ToLower(const std::string& str);
 
+// Делит строку на слова по пробелам. Текст в кавычках считается одним словом
+void SplitWords(std::string_view line, std::vector<std::string_view>& words);
+
 class Parser {
  public:
     using CommandOption = std::variant<std::monostate, ListOption, ConfigOption>;
@@ -31,19 +47,46 @@ class Parser {
 
     const CommandOption& GetCommandOption() const { return command_.option; }
 
-    const std::string& GetTaskText() const { return command_.text; }
+    // Текст ссылается на разобранные слова либо на внутренний буфер парсера:
+    // он действителен до следующего вызова Parse и пока живы исходные слова
+    std::string_view GetTaskText() const {
+        return command_.text_in_buffer ? std::string_view(text_buffer_) : command_.text;
+    }
 
     const std::optional<size_t>& GetTaskIndex() const { return command_.task_index; }
 
+    // Все номера задач для done и remove по возрастанию
+    std::span<const size_t> GetTaskIndices() const { return task_indices_; }
+
+    OutputFormat GetOutputFormat() const { return command_.format; }
+
+    const task::ListRange& GetListRange() const { return command_.range; }
+
+    size_t GetSaveEvery() const { return command_.save_every; }
+
     void Parse(int& argc, char** argv);
+    // Разбор без имени программы: args[0] - имя команды
+    void Parse(std::span<const std::string_view> args);
 
  private:
     struct Command {
         TypeCommand type = TypeCommand::HELP;
         CommandOption option = std::monostate{};
-        std::string text = "";
+        std::string_view text;
+        bool text_in_buffer = false;
         std::optional<size_t> task_index = std::nullopt;
+        OutputFormat format = OutputFormat::PLAIN;
+        task::ListRange range;
+        size_t save_every = 0;
     } command_;
+
+    // Переиспользуются между вызовами Parse, поэтому повторный разбор не выделяет память
+    std::vector<std::string_view> args_;
+    std::string text_buffer_;
+    std::vector<size_t> task_indices_;
+
+    void AppendText(std::span<const std::string_view> words);
+    int ParseFlag(std::span<const std::string_view> args, size_t index);
 };
 
 }  // namespace parser
@@ -0,0 +1,122 @@
+#include "Output.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+namespace task {
+
+OutputFormat FormatFromString(std::string_view name) {
+    // Сравнение без учета регистра и без временных строк
+    auto equals = [name](std::string_view format) {
+        return std::ranges::equal(name, format, [](char lhs, char rhs) {
+            return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+        });
+    };
+
+    if (equals("plain")) {
+        return OutputFormat::PLAIN;
+    }
+    if (equals("json")) {
+        return OutputFormat::JSON;
+    }
+    if (equals("ndjson")) {
+        return OutputFormat::NDJSON;
+    }
+    throw std::invalid_argument(std::format("Unknown output format - {}", name));
+}
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity) : fd_(fd), capacity_(capacity) {
+    // Небольшой запас, чтобы последняя строка не вызывала перераспределение
+    buffer_.reserve(capacity_ + capacity_ / 8);
+}
+
+OutputBuffer::~OutputBuffer() {
+    try {
+        Flush();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+void OutputBuffer::Write(std::string_view text) {
+    buffer_.append(text);
+    FlushIfFull();
+}
+
+void OutputBuffer::Write(char c) {
+    buffer_.push_back(c);
+    FlushIfFull();
+}
+
+void OutputBuffer::WriteJsonString(std::string_view text) {
+    buffer_.push_back('"');
+    for (const char c : text) {
+        switch (c) {
+            case '"':
+                buffer_.append("\\\"");
+                break;
+            case '\\':
+                buffer_.append("\\\\");
+                break;
+            case '\n':
+                buffer_.append("\\n");
+                break;
+            case '\r':
+                buffer_.append("\\r");
+                break;
+            case '\t':
+                buffer_.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    std::format_to(std::back_inserter(buffer_), "\\u{:04x}",
+                                   static_cast<unsigned>(c));
+                } else {
+                    buffer_.push_back(c);
+                }
+                break;
+        }
+    }
+    buffer_.push_back('"');
+    FlushIfFull();
+}
+
+void OutputBuffer::Flush() {
+    if (fd_ == NO_FD || buffer_.empty()) {
+        return;
+    }
+
+    // Сохраняем порядок вывода относительно std::cout и stdio
+    if (fd_ == STDOUT_FD) {
+        std::cout.flush();
+        std::fflush(stdout);
+    }
+
+    const char* data = buffer_.data();
+    size_t left = buffer_.size();
+    while (left > 0) {
+        const ssize_t written = ::write(fd_, data, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const std::error_code ec(errno, std::generic_category());
+            buffer_.clear();
+            throw std::runtime_error(std::format("Failed to write output: {}", ec.message()));
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+    buffer_.clear();
+}
+
+void OutputBuffer::Clear() { buffer_.clear(); }
+
+}  // namespace task
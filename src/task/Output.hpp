@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace task {
+
+enum class OutputFormat { PLAIN, JSON, NDJSON };
+
+OutputFormat FormatFromString(std::string_view name);
+
+// Окно списка: from — позиция первой задачи, count — сколько задач вывести
+struct ListRange {
+    static constexpr size_t ALL = std::numeric_limits<size_t>::max();
+
+    size_t from = 0;
+    size_t count = ALL;
+
+    bool IsFull() const { return from == 0 && count == ALL; }
+};
+
+// Буфер вывода: накапливает текст через std::format_to и сбрасывает его
+// в файловый дескриптор крупными вызовами write(2).
+// С дескриптором NO_FD текст только накапливается и доступен через GetData()
+class OutputBuffer {
+ public:
+    static constexpr int NO_FD = -1;
+    static constexpr int STDOUT_FD = 1;
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit OutputBuffer(int fd = STDOUT_FD, size_t capacity = DEFAULT_CAPACITY);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    template <typename... Args>
+    void Print(std::format_string<Args...> fmt, Args&&... args) {
+        std::format_to(std::back_inserter(buffer_), fmt, std::forward<Args>(args)...);
+        FlushIfFull();
+    }
+
+    void Write(std::string_view text);
+    void Write(char c);
+    void WriteJsonString(std::string_view text);
+
+    void Flush();
+    void Clear();
+
+    const std::string& GetData() const { return buffer_; }
+
+ private:
+    int fd_;
+    size_t capacity_;
+    std::string buffer_;
+
+    void FlushIfFull() {
+        if (buffer_.size() >= capacity_) {
+            Flush();
+        }
+    }
+};
+
+}  // namespace task
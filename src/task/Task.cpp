@@ -1,36 +1,93 @@
 #include "Task.hpp"
 
+#include "Trace.hpp"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <format>
 #include <fstream>
-#include <iostream>
+#include <functional>
+#include <iterator>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
 
 namespace task {
 
-TaskManager::TaskManager(const std::string& config_path) : config_path_(config_path) {
-    std::ifstream fin(config_path_);
+uint64_t TaskManager::NextVersion() {
+    static std::atomic<uint64_t> last_version = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    return ++last_version;
+}
+
+ListConfig ReadConfig(const std::string& config_path) {
+    std::ifstream fin(config_path);
     if (!fin) {
         const std::string error_message = std::format(
             "Failed to open config file: {}\nSelect config file with command: todo config "
             "<path-to-dir>",
-            config_path_);
+            config_path);
         throw std::runtime_error(error_message);
     }
 
-    json j = json::parse(fin);
+    nlohmann::json j = nlohmann::json::parse(fin);
 
-    path_ = static_cast<std::string>(j["path"]);
-    filename_ = static_cast<std::string>(j["name"]);
+    ListConfig config;
+    config.path = static_cast<std::string>(j["path"]);
+    config.name = static_cast<std::string>(j["name"]);
+    return config;
+}
 
-    fin.close();
+TaskManager::TaskManager(const std::string& config_path) : config_path_(config_path) {
+    ListConfig config = ReadConfig(config_path_);
+    path_ = std::move(config.path);
+    filename_ = std::move(config.name);
 
     full_name_ = path_ + "/" + filename_;
     LoadTasksFromFile(full_name_);
 }
 
+TaskManager::TaskManager(FromFileTag, const std::string& full_name, bool load) {
+    const fs::path path(full_name);
+    path_ = path.parent_path().string();
+    filename_ = path.filename().string();
+    full_name_ = full_name;
+    if (load) {
+        LoadTasksFromFile(full_name_);
+    }
+}
+
+void TaskManager::ReloadConfig() {
+    if (config_path_.empty()) {
+        throw std::logic_error("Task list was opened without a config file");
+    }
+    *this = TaskManager(config_path_);
+}
+
+TaskManager TaskManager::FromFile(const std::string& full_name) {
+    return TaskManager(FromFileTag{}, full_name);
+}
+
+TaskManager TaskManager::FromJson(const json& tasks, const std::string& full_name) {
+    TaskManager manager(FromFileTag{}, full_name, false);
+    manager.LoadTasks(tasks, full_name);
+    return manager;
+}
+
 void TaskManager::LoadTasksFromFile(const std::string& filename) {
+    trace::Span span("task", "TaskManager::LoadTasksFromFile");
     if (!fs::exists(filename)) {
         tasks_.clear();
+        version_ = NextVersion();
         return;
     }
 
@@ -49,60 +106,67 @@ void TaskManager::LoadTasksFromFile(const std::string& filename) {
     if (file_size == 0) {
         // Если файл пустой, очищаем список задач и возвращаемся
         tasks_.clear();
+        version_ = NextVersion();
         fin.close();
         return;
     }
 
-    json j = json::parse(fin);
+    const json j = json::parse(fin);
+    fin.close();
+    LoadTasks(j, filename);
+}
 
+void TaskManager::LoadTasks(const json& j, const std::string& source) {
+    trace::Span span("task", "TaskManager::LoadTasks");
     // Проверяем, что JSON является массивом
     if (!j.is_array()) {
-        fin.close();
         const std::string error_message =
-            std::format("Invalid file format in {}: expected an array of tasks", filename);
+            std::format("Invalid file format in {}: expected an array of tasks", source);
         throw std::runtime_error(error_message);
     }
 
-    tasks_.clear();
+    std::vector<Task> tasks;
+    tasks.reserve(j.size());
     for (const auto& task : j) {
         // Проверяем, что каждый элемент является объектом
         if (!task.is_object()) {
-            fin.close();
             const std::string error_message =
-                std::format("Invalid task format in {}: task must be a JSON object", filename);
+                std::format("Invalid task format in {}: task must be a JSON object", source);
             throw std::runtime_error(error_message);
         }
 
         // Проверяем, что каждый элемент имеет необходимые поля
         if (!task.contains("text") || !task.contains("done")) {
-            fin.close();
             const std::string error_message =
-                std::format("Invalid task format in {}: missing 'text' or 'done' field", filename);
+                std::format("Invalid task format in {}: missing 'text' or 'done' field", source);
             throw std::runtime_error(error_message);
         }
 
         // Проверяем типы полей
         if (!task["text"].is_string()) {
-            fin.close();
             const std::string error_message =
-                std::format("Invalid task format in {}: 'text' field must be a string", filename);
+                std::format("Invalid task format in {}: 'text' field must be a string", source);
             throw std::runtime_error(error_message);
         }
 
         if (!task["done"].is_boolean()) {
-            fin.close();
             const std::string error_message =
-                std::format("Invalid task format in {}: 'done' field must be a boolean", filename);
+                std::format("Invalid task format in {}: 'done' field must be a boolean", source);
             throw std::runtime_error(error_message);
         }
 
-        tasks_.push_back(Task(task["text"], task["done"]));
+        tasks.push_back(Task(task["text"], task["done"]));
     }
 
-    fin.close();
+    tasks_ = std::move(tasks);
+    // У каждой задачи своя версия: по ней кэши отличают задачи, сдвинутые удалением
+    version_ = NextVersion();
+    for (Task& task : tasks_) {
+        Touch(task);
+    }
 }
 
-void TaskManager::AddTask(const std::string& text) {
+void TaskManager::AddTask(std::string_view text) {
     if (text.empty()) {
         throw std::invalid_argument("Task text cannot be empty");
     }
@@ -111,10 +175,10 @@ void TaskManager::AddTask(const std::string& text) {
         throw std::invalid_argument("Task text is too long (maximum 1000 characters)");
     }
     
-    tasks_.emplace_back(text, false);
+    Touch(tasks_.emplace_back(std::string(text), false));
 }
 
-void TaskManager::AddTask(const Task& task) { tasks_.emplace_back(task); }
+void TaskManager::AddTask(const Task& task) { Touch(tasks_.emplace_back(task)); }
 
 void TaskManager::ToggleTask(size_t index) {
     if (index >= tasks_.size()) {
@@ -124,6 +188,7 @@ void TaskManager::ToggleTask(size_t index) {
         throw std::out_of_range(error_message);
     }
     tasks_[index].done = !tasks_[index].done;
+    Touch(tasks_[index]);
 }
 
 bool TaskManager::TaskExists(size_t index) const { return index < tasks_.size(); }
@@ -136,11 +201,55 @@ void TaskManager::RemoveTask(size_t index) {
         throw std::out_of_range(error_message);
     }
     tasks_.erase(tasks_.begin() + index);
+    version_ = NextVersion();
+}
+
+void TaskManager::ToggleTasks(std::span<const size_t> indices) {
+    CheckIndices(indices);
+    for (const size_t index : indices) {
+        tasks_[index].done = !tasks_[index].done;
+        Touch(tasks_[index]);
+    }
+}
+
+void TaskManager::RemoveTasks(std::span<const size_t> indices) {
+    CheckIndices(indices);
+
+    // Одно уплотнение вектора вместо erase на каждый номер
+    size_t position = 0;
+    auto next = indices.begin();
+    const auto removed = std::remove_if(tasks_.begin(), tasks_.end(), [&](const Task&) {
+        const bool remove = next != indices.end() && *next == position;
+        if (remove) {
+            ++next;
+        }
+        ++position;
+        return remove;
+    });
+    tasks_.erase(removed, tasks_.end());
+    version_ = NextVersion();
+}
+
+void TaskManager::CheckIndices(std::span<const size_t> indices) const {
+    if (std::adjacent_find(indices.begin(), indices.end(), std::greater_equal<>()) !=
+        indices.end()) {
+        throw std::invalid_argument("Task indices must be sorted and unique");
+    }
+    if (!indices.empty() && indices.back() >= tasks_.size()) {
+        const size_t missing = *std::lower_bound(indices.begin(), indices.end(), tasks_.size());
+        const std::string error_message = std::format(
+            "Task with index {} does not exist.\nRecheck list and choose different task index",
+            missing);
+        throw std::out_of_range(error_message);
+    }
 }
 
-void TaskManager::ClearTasks() { tasks_.clear(); }
+void TaskManager::ClearTasks() {
+    tasks_.clear();
+    version_ = NextVersion();
+}
 
-void TaskManager::EditTask(size_t index, const std::string& new_text) {
+void TaskManager::EditTask(size_t index, std::string_view new_text) {
     if (index >= tasks_.size()) {
         const std::string error_message = std::format(
             "Task with index {} does not exist.\nRecheck list and choose different task index",
@@ -148,89 +257,119 @@ void TaskManager::EditTask(size_t index, const std::string& new_text) {
         throw std::out_of_range(error_message);
     }
     tasks_[index].text = new_text;
+    Touch(tasks_[index]);
 }
 
 const std::vector<Task>& TaskManager::GetTasks() const { return tasks_; }
 
 void TaskManager::PrintTasks() const {
-    if (tasks_.empty()) {
-        std::cout << "No tasks found.\n";
-        return;
-    }
-
-    for (size_t i = 0; i != tasks_.size(); ++i) {
-        std::cout << i << ". ";
-        if (tasks_[i].done) {
-            std::cout << "[x] ";
-        } else {
-            std::cout << "[ ] ";
-        }
-        std::cout << tasks_[i].text << "\n";
-    }
+    OutputBuffer out;
+    RenderTasks(out, std::nullopt, ListRange{}, OutputFormat::PLAIN);
 }
 
 void TaskManager::PrintTasks(bool only_completed) const {
-    if (tasks_.empty()) {
-        std::cout << "No tasks found.\n";
-        return;
+    OutputBuffer out;
+    RenderTasks(out, only_completed, ListRange{}, OutputFormat::PLAIN);
+}
+
+void TaskManager::PrintTasks(OutputBuffer& out, OutputFormat format) const {
+    RenderTasks(out, std::nullopt, ListRange{}, format);
+}
+
+void TaskManager::PrintTasks(OutputBuffer& out, bool only_completed, OutputFormat format) const {
+    RenderTasks(out, only_completed, ListRange{}, format);
+}
+
+size_t TaskManager::PrintTasks(OutputBuffer& out, std::optional<bool> only_completed,
+                               const ListRange& range, OutputFormat format) const {
+    return RenderTasks(out, only_completed, range, format);
+}
+
+size_t TaskManager::CountTasks(std::optional<bool> only_completed) const {
+    if (!only_completed.has_value()) {
+        return tasks_.size();
     }
+    return static_cast<size_t>(std::count_if(tasks_.begin(), tasks_.end(), [&](const Task& task) {
+        return task.done == *only_completed;
+    }));
+}
 
-    bool found = false;
-    for (size_t i = 0; i < tasks_.size(); ++i) {
-        if (only_completed == tasks_[i].done) {
-            std::cout << i << ". ";
-            if (tasks_[i].done) {
-                std::cout << "[x] ";
-            } else {
-                std::cout << "[ ] ";
-            }
-            std::cout << tasks_[i].text << "\n";
-            found = true;
+size_t TaskManager::RenderTasks(OutputBuffer& out, std::optional<bool> only_completed,
+                                const ListRange& range, OutputFormat format) const {
+    if (format == OutputFormat::JSON) {
+        out.Write('[');
+    }
+
+    // Без фильтра окно адресуется напрямую, с фильтром пропускаем from подходящих задач
+    const bool filtered = only_completed.has_value();
+    size_t skip = filtered ? range.from : 0;
+    size_t shown = 0;
+    std::string line;
+    for (size_t i = filtered ? 0 : std::min(range.from, tasks_.size());
+         i < tasks_.size() && shown < range.count; ++i) {
+        const Task& task = tasks_[i];
+        if (filtered && *only_completed != task.done) {
+            continue;
+        }
+        if (skip > 0) {
+            --skip;
+            continue;
         }
-    }
 
-    if (!found) {
-        if (only_completed) {
-            std::cout << "No completed tasks found.\n";
-        } else {
-            std::cout << "No pending tasks found.\n";
+        switch (format) {
+            case OutputFormat::PLAIN:
+                line.clear();
+                AppendTaskLine(line, i, task);
+                out.Write(line);
+                break;
+            case OutputFormat::JSON:
+            case OutputFormat::NDJSON:
+                if (format == OutputFormat::JSON && shown > 0) {
+                    out.Write(',');
+                }
+                out.Print("{{\"index\":{},\"text\":", i);
+                out.WriteJsonString(task.text);
+                out.Print(",\"done\":{}}}", task.done);
+                if (format == OutputFormat::NDJSON) {
+                    out.Write('\n');
+                }
+                break;
         }
+        ++shown;
     }
-}
 
-void TaskManager::Save() const {
-    json j = json::array();
-    for (const Task& task : tasks_) {
-        j.push_back({{"text", task.text}, {"done", task.done}});
+    if (format == OutputFormat::JSON) {
+        out.Write("]\n");
+        return shown;
     }
 
-    // Проверяем существование директории и создаем её при необходимости
-    const fs::path dir_path = fs::path(full_name_).parent_path();
-    if (!dir_path.empty() && !fs::exists(dir_path)) {
-        std::error_code ec;
-        fs::create_directories(dir_path, ec);
-        if (ec) {
-            const std::string error_message =
-                std::format("Failed to create directory {}: {}", dir_path.string(), ec.message());
-            throw std::runtime_error(error_message);
-        }
+    if (shown > 0 || format != OutputFormat::PLAIN) {
+        return shown;
     }
 
-    std::ofstream fout(full_name_);
-    if (!fout) {
-        const std::string error_message =
-            std::format("Failed to open file for writing: {}", full_name_);
-        throw std::runtime_error(error_message);
+    if (tasks_.empty()) {
+        out.Write("No tasks found.\n");
+    } else if (!range.IsFull()) {
+        out.Write("No tasks in the requested range.\n");
+    } else if (*only_completed) {
+        out.Write("No completed tasks found.\n");
+    } else {
+        out.Write("No pending tasks found.\n");
     }
-    fout << j.dump(4);
-    fout.close();
+    return shown;
+}
 
-    // Проверяем, что файл был успешно записан
-    if (fout.fail()) {
-        const std::string error_message =
-            std::format("Failed to write data to file: {}", full_name_);
-        throw std::runtime_error(error_message);
+TaskManager::json TaskManager::ToJson() const {
+    json j = json::array();
+    for (const Task& task : tasks_) {
+        j.push_back({{"text", task.text}, {"done", task.done}});
     }
+    return j;
+}
+
+void TaskManager::Save() const {
+    trace::Span span("task", "TaskManager::Save");
+    WriteFileAtomically(full_name_, ToJson().dump(4));
 }
 
 void TaskManager::SetPath(const std::string& path, const std::string& config_path) {
@@ -328,6 +467,112 @@ const std::string& TaskManager::GetFullName() const { return full_name_; }
 
 // ------- Функции -------
 
+void AppendTaskLine(std::string& out, size_t index, const Task& task) {
+    std::format_to(std::back_inserter(out), "{}. [{}] {}\n", index, task.done ? 'x' : ' ',
+                   task.text);
+}
+
+namespace {
+
+#ifndef WIN32
+std::runtime_error FileError(std::string_view what, const std::string& name) {
+    const std::error_code ec(errno, std::generic_category());
+    return std::runtime_error(std::format("{} {}: {}", what, name, ec.message()));
+}
+
+// Пишет файл и дожидается, пока данные дойдут до диска
+void WriteFileSynced(const std::string& name, std::string_view data) {
+    const int fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw FileError("Failed to open file for writing", name);
+    }
+    while (!data.empty()) {
+        const ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            const std::runtime_error error = FileError("Failed to write data to file", name);
+            ::close(fd);
+            throw error;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    if (::fsync(fd) != 0) {
+        const std::runtime_error error = FileError("Failed to sync file", name);
+        ::close(fd);
+        throw error;
+    }
+    if (::close(fd) != 0) {
+        throw FileError("Failed to close file", name);
+    }
+}
+
+// Переименование попадает на диск только вместе с записью каталога
+void SyncDirectory(const fs::path& dir) {
+    const std::string name = dir.empty() ? "." : dir.string();
+    const int fd = ::open(name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw FileError("Failed to open directory", name);
+    }
+    if (::fsync(fd) != 0) {
+        const std::runtime_error error = FileError("Failed to sync directory", name);
+        ::close(fd);
+        throw error;
+    }
+    ::close(fd);
+}
+#else
+void WriteFileSynced(const std::string& name, std::string_view data) {
+    std::ofstream fout(name, std::ios::binary | std::ios::trunc);
+    if (!fout) {
+        const std::string error_message = std::format("Failed to open file for writing: {}", name);
+        throw std::runtime_error(error_message);
+    }
+    fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+    fout.close();
+
+    // Проверяем, что файл был успешно записан
+    if (fout.fail()) {
+        const std::string error_message = std::format("Failed to write data to file: {}", name);
+        throw std::runtime_error(error_message);
+    }
+}
+
+void SyncDirectory(const fs::path&) {}
+#endif
+
+}  // namespace
+
+void WriteFileAtomically(const std::string& filename, std::string_view data) {
+    trace::Span span("task", "WriteFileAtomically");
+    // Проверяем существование директории и создаем её при необходимости
+    const fs::path dir_path = fs::path(filename).parent_path();
+    if (!dir_path.empty() && !fs::exists(dir_path)) {
+        std::error_code ec;
+        fs::create_directories(dir_path, ec);
+        if (ec) {
+            const std::string error_message =
+                std::format("Failed to create directory {}: {}", dir_path.string(), ec.message());
+            throw std::runtime_error(error_message);
+        }
+    }
+
+    // Пишем во временный файл и подменяем им старый: после сбоя, в том числе
+    // отключения питания, на диске остается либо прежнее, либо новое содержимое целиком
+    const std::string temp_name = filename + ".tmp";
+    WriteFileSynced(temp_name, data);
+
+    std::error_code ec;
+    fs::rename(temp_name, filename, ec);
+    if (ec) {
+        const std::string error_message =
+            std::format("Failed to replace file {}: {}", filename, ec.message());
+        throw std::runtime_error(error_message);
+    }
+    SyncDirectory(dir_path);
+}
+
 void MakeDefaultConfig() {
     using nlohmann::json;
 
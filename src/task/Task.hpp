@@ -1,9 +1,15 @@
 #pragma once
 
+#include "Output.hpp"
+
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
 #include <filesystem>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace task {
@@ -18,9 +24,23 @@ const std::string DEFAULT_CONFIG_NAME = "config_todo.json"s;
 const std::string DEFAULT_OUTPUT_DIR = "../notepad"s;
 const std::string DEFAULT_LIST = "checklist.json"s;
 
+// Где лежит список задач по файлу конфигурации
+struct ListConfig {
+    std::string path;
+    std::string name;
+
+    std::string GetFullName() const { return path + "/" + name; }
+};
+
+// Читает файл конфигурации, сам список не загружается
+ListConfig ReadConfig(const std::string& config_path = DEFAULT_CONFIG_DIR + "/" + DEFAULT_CONFIG_NAME);
+
 struct Task {
     std::string text;
     bool done = false;
+    // Версия списка (TaskManager::GetVersion), в которой задачу загрузили, добавили
+    // или изменили. Своя у каждой задачи. В файл не пишется
+    uint64_t revision = 0;
 
     Task() = default;
     Task(const std::string& text_task, bool done_task) : text(text_task), done(done_task) {}
@@ -32,33 +52,78 @@ class TaskManager {
 
     TaskManager(const std::string& config_path = DEFAULT_CONFIG_DIR + "/" + DEFAULT_CONFIG_NAME);
 
+    // Список из файла full_name без чтения конфигурации. Файла может еще не быть:
+    // он создается при первом Save()
+    static TaskManager FromFile(const std::string& full_name);
+    // Список из уже разобранного массива задач, сохраняется в full_name
+    static TaskManager FromJson(const json& tasks, const std::string& full_name);
+
     void LoadTasksFromFile(const std::string& filename);
-    void AddTask(const std::string& text);
+    // Заменяет задачи массивом из JSON. source используется в сообщениях об ошибках
+    void LoadTasks(const json& tasks, const std::string& source);
+    json ToJson() const;
+    void AddTask(std::string_view text);
     void AddTask(const Task& task);
     void ToggleTask(size_t index);
     void RemoveTask(size_t index);
+    // Групповые операции за один проход. Номера должны идти по возрастанию без повторов
+    void ToggleTasks(std::span<const size_t> indices);
+    void RemoveTasks(std::span<const size_t> indices);
     void ClearTasks();
-    void EditTask(size_t index, const std::string& new_text);
+    void EditTask(size_t index, std::string_view new_text);
     bool TaskExists(size_t index) const;
     void Save() const;
     
     const std::vector<Task>& GetTasks() const;
+    // Растет при каждом изменении списка. Вместе с Task::revision позволяет кэшам
+    // узнать, какие задачи изменились или сдвинулись
+    uint64_t GetVersion() const { return version_; }
     void PrintTasks() const;
     void PrintTasks(bool only_completed) const;
+    void PrintTasks(OutputBuffer& out, OutputFormat format = OutputFormat::PLAIN) const;
+    void PrintTasks(OutputBuffer& out, bool only_completed,
+                    OutputFormat format = OutputFormat::PLAIN) const;
+    size_t PrintTasks(OutputBuffer& out, std::optional<bool> only_completed,
+                      const ListRange& range, OutputFormat format = OutputFormat::PLAIN) const;
+    size_t CountTasks(std::optional<bool> only_completed = std::nullopt) const;
 
     static void SetPath(const std::string& path, const std::string& config_path = DEFAULT_CONFIG_DIR + "/" + DEFAULT_CONFIG_NAME);
     static void SetName(const std::string& name, const std::string& config_path = DEFAULT_CONFIG_DIR + "/" + DEFAULT_CONFIG_NAME);
 
     const std::string& GetFullName() const;
+    // Пустой, если список открыт без файла конфигурации (FromFile, FromJson)
+    const std::string& GetConfigPath() const { return config_path_; }
+    // Перечитывает конфигурацию и открывает указанный в ней список.
+    // Несохраненные изменения текущего списка теряются
+    void ReloadConfig();
 
  private:
     std::vector<Task> tasks_;
+    uint64_t version_ = 0;
     std::string config_path_;
     std::string path_;
     std::string filename_;
     std::string full_name_;
+
+    struct FromFileTag {};
+    TaskManager(FromFileTag, const std::string& full_name, bool load = true);
+
+    size_t RenderTasks(OutputBuffer& out, std::optional<bool> only_completed,
+                       const ListRange& range, OutputFormat format) const;
+    void CheckIndices(std::span<const size_t> indices) const;
+    // Следующая версия. Счетчик общий для всех списков процесса и начинается со
+    // времени запуска, поэтому версия задачи не повторяется и после загрузки списка заново
+    static uint64_t NextVersion();
+    // Новая версия списка, которой помечается измененная задача
+    void Touch(Task& task) { task.revision = version_ = NextVersion(); }
 };
 
+// Строка задачи в простом формате: "3. [x] текст"
+void AppendTaskLine(std::string& out, size_t index, const Task& task);
+
 void MakeDefaultConfig();
 
+// Записывает файл целиком через временный файл и переименование
+void WriteFileAtomically(const std::string& filename, std::string_view data);
+
 }  // namespace task
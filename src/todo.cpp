@@ -1,156 +1,101 @@
+#include "Batch.hpp"
+#include "Daemon.hpp"
+#include "Executor.hpp"
 #include "Parser.hpp"
+#include "Shell.hpp"
 #include "Task.hpp"
+#include "Trace.hpp"
 
+#include <cstdlib>
 #include <filesystem>
-#include <format>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace fs = std::filesystem;
 
 using namespace task;
 using namespace parser;
-using CommandOption = Parser::CommandOption;
-
-void PrintHelp() {
-    std::cout << "Todo List Manager\n";
-    std::cout << "Usage: todo [command] [arguments]\n\n";
-    std::cout << "Commands:\n";
-    std::cout << "  add <text>          Add a new task\n";
-    std::cout << "  list                Show all tasks\n";
-    std::cout << "  list pending        Show pending tasks\n";
-    std::cout << "  list completed      Show completed tasks\n";
-    std::cout << "  clear               Clear all tasks\n";
-    std::cout << "  done <index>        Toggle task completion status\n";
-    std::cout << "  remove <index>      Remove a task\n";
-    std::cout << "  edit <index> <text> Edit a task\n";
-    std::cout << "  config path <path>  Set the path for task files\n";
-    std::cout << "  config name <name>  Set the filename for task list\n";
-    std::cout << "  help                Show this help message\n";
-}
 
 int main(int argc, char** argv) {
+    // CHECKLIST_TRACE=trace.json: при выходе трасса пишется в файл для chrome://tracing
+    const char* trace_path = std::getenv("CHECKLIST_TRACE");
+    const trace::TraceSession trace_session(trace_path != nullptr ? trace_path : "");
+
     try {
         if (!fs::exists(DEFAULT_CONFIG_DIR) || !fs::exists(DEFAULT_OUTPUT_DIR)) {
             MakeDefaultConfig();
         }
 
-        TaskManager manager(DEFAULT_CONFIG_DIR + "/" + DEFAULT_CONFIG_NAME);
+        const std::string config_path = DEFAULT_CONFIG_DIR + "/" + DEFAULT_CONFIG_NAME;
+        const std::string socket_path = cli::DefaultSocketPath();
 
         Parser parser;
         parser.Parse(argc, argv);
 
         const TypeCommand type_command = parser.GetTypeCommand();
-        switch (type_command) {
-            case TypeCommand::HELP:
-                PrintHelp();
-                break;
-            case TypeCommand::ADD:
-                manager.AddTask(parser.GetTaskText());
-                manager.Save();
-                std::cout << "Task added successfully.\n";
-                break;
-            case TypeCommand::LIST: {
-                const CommandOption command_option = parser.GetCommandOption();
-                if (auto pList = std::get_if<ListOption>(&command_option)) {
-                    const auto& list_option = *pList;
-                    switch (list_option) {
-                        case ListOption::PENDING:
-                            manager.PrintTasks(false);
-                            break;
-                        case ListOption::COMPLETED:
-                            manager.PrintTasks(true);
-                            break;
-                    }
-                } else {
-                    manager.PrintTasks();
-                }
-                break;
+        if (type_command == TypeCommand::DAEMON) {
+            cli::Daemon daemon(config_path, socket_path);
+            daemon.Run();
+            return 0;
+        }
+
+        if (type_command == TypeCommand::SHELL) {
+            // Демон сохранил бы поверх изменений оболочки
+            if (cli::IsDaemonRunning(socket_path)) {
+                throw std::runtime_error("Todo daemon is running: stop it before starting shell");
             }
-            case TypeCommand::CLEAR:
-                manager.ClearTasks();
-                manager.Save();
-                std::cout << "All tasks in "s << manager.GetFullName() << " cleared successfully\n";
-                break;
-            case TypeCommand::DONE: {
-                const std::optional<size_t> index_opt = parser.GetTaskIndex();
-                if (index_opt == std::nullopt) {
-                    throw std::runtime_error("Task index was not specified"s);
-                }
+            TaskManager manager(config_path);
+            cli::Shell shell(manager);
+            shell.Run();
+            return 0;
+        }
 
-                const size_t index = index_opt.value();
-                if (!manager.TaskExists(index)) {
-                    const std::string message =
-                        std::format("Task with index {} does not exist", index);
-                    throw std::runtime_error(message);
-                }
+        std::string script;
+        if (type_command == TypeCommand::BATCH) {
+            script = cli::ReadBatchScript(parser.GetTaskText());
+        }
 
-                manager.ToggleTask(index);
-                manager.Save();
-                std::cout << std::format("Task with index {} toggled successfully", index) << '\n';
-                break;
-            }
-            case TypeCommand::REMOVE: {
-                const std::optional<size_t> index_opt = parser.GetTaskIndex();
-                if (index_opt == std::nullopt) {
-                    throw std::runtime_error("Task index was not specified"s);
+        // Если демон запущен, список уже загружен в нем - передаем команду ему
+        if (type_command != TypeCommand::HELP) {
+            const std::vector<std::string_view> args(argv + 1, argv + argc);
+            if (const std::optional<int> status = cli::ForwardToDaemon(socket_path, args, script)) {
+                if (type_command == TypeCommand::BATCH) {
+                    return *status;
                 }
-
-                const size_t index = index_opt.value();
-                if (!manager.TaskExists(index)) {
-                    const std::string message =
-                        std::format("Task with index {} does not exist", index);
-                    throw std::runtime_error(message);
+                // Как и при локальном выполнении: ошибка, затем справка
+                if (*status != 0) {
+                    OutputBuffer out;
+                    cli::PrintHelp(out);
                 }
-
-                manager.RemoveTask(index);
-                manager.Save();
-                std::cout << std::format("Task with index {} removed successfully", index) << '\n';
-                break;
+                return 0;
             }
-            case TypeCommand::EDIT: {
-                const std::optional<size_t> index_opt = parser.GetTaskIndex();
-                if (index_opt == std::nullopt) {
-                    throw std::runtime_error("Task index was not specified"s);
-                }
+        }
 
-                const size_t index = index_opt.value();
-                if (!manager.TaskExists(index)) {
-                    const std::string message =
-                        std::format("Task with index {} does not exist", index);
-                    throw std::runtime_error(message);
-                }
+        TaskManager manager(config_path);
 
-                manager.EditTask(index, parser.GetTaskText());
-                manager.Save();
-                std::cout << std::format("Task with index {} edited successfully", index) << '\n';
-                break;
-            }
-            case TypeCommand::CONFIG: {
-                const CommandOption command_option = parser.GetCommandOption();
-                if (auto pConfig = std::get_if<ConfigOption>(&command_option)) {
-                    const auto& config_option = *pConfig;
-                    switch (config_option) {
-                        // TODO: Решить как и что проверять для параметра пути и имени
-                        case ConfigOption::PATH:
-                            manager.SetPath(parser.GetTaskText());
-                            std::cout << "Path updated successfully.\n";
-                            break;
-                        case ConfigOption::NAME:
-                            manager.SetName(parser.GetTaskText());
-                            std::cout << "Filename updated successfully.\n";
-                            break;
-                    }
-                }
-                break;
-            }
-            default:
-                break;
+        OutputBuffer out;
+        if (type_command == TypeCommand::BATCH) {
+            // Один процесс, одна загрузка и одно сохранение на весь скрипт
+            const cli::BatchStats stats =
+                cli::RunBatch(manager, script, parser.GetSaveEvery(), out, std::cerr);
+            out.Flush();
+            return stats.failed == 0 ? 0 : 1;
+        }
+
+        cli::Executor executor(manager);
+        if (executor.Execute(parser, out)) {
+            manager.Save();
         }
+        out.Flush();
 
     } catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
-        PrintHelp();
+        OutputBuffer out;
+        cli::PrintHelp(out);
     }
 
     return 0;
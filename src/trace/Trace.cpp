@@ -0,0 +1,239 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+// Слоты пишет только поток-владелец, а читает запись трассы, поэтому поля атомарные
+struct Event {
+    std::atomic<const char*> category = nullptr;
+    std::atomic<const char*> name = nullptr;
+    std::atomic<int64_t> start = 0;
+    std::atomic<int64_t> end = 0;
+    // Не 0 у AsyncSpan
+    std::atomic<uint64_t> async_id = 0;
+};
+
+struct ThreadBuffer {
+    size_t id = 0;
+    // Под мьютексом реестра
+    std::string name;
+    // Сколько событий записано за все время и с какого начинаются неудаленные
+    std::atomic<uint64_t> written = 0;
+    std::atomic<uint64_t> begin = 0;
+    std::array<Event, RING_SIZE> events;
+};
+
+// Буферы переживают свои потоки, чтобы в трассу попали и завершенные
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+const std::chrono::steady_clock::time_point EPOCH = std::chrono::steady_clock::now();
+
+thread_local ThreadBuffer* thread_buffer = nullptr;
+thread_local std::string thread_name;
+
+// Буфер создается при первом событии потока, чтобы потоки без событий не занимали память
+ThreadBuffer& GetThreadBuffer() {
+    if (thread_buffer == nullptr) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        buffer->id = registry.buffers.size() + 1;
+        buffer->name = thread_name.empty() ? std::format("thread {}", buffer->id) : thread_name;
+        registry.buffers.push_back(buffer);
+        thread_buffer = buffer.get();
+    }
+    return *thread_buffer;
+}
+
+std::string EscapeJson(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += std::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+namespace detail {
+
+std::atomic<bool> enabled = false;
+
+int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - EPOCH)
+        .count();
+}
+
+void Record(const char* category, const char* name, int64_t start, int64_t end,
+            uint64_t async_id) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    Event& event = buffer.events[index % RING_SIZE];
+    event.category.store(category, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.async_id.store(async_id, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+uint64_t NextAsyncId() {
+    static std::atomic<uint64_t> last_id = 0;
+    return last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+}  // namespace detail
+
+void Enable(bool enabled) { detail::enabled.store(enabled && COMPILED_IN); }
+
+void SetThreadName(std::string name) {
+    if (thread_buffer != nullptr) {
+        std::lock_guard lock(GetRegistry().mutex);
+        thread_buffer->name = name;
+    }
+    thread_name = std::move(name);
+}
+
+size_t GetEventCount() {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    size_t count = 0;
+    for (const auto& buffer : registry.buffers) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t begin = buffer->begin.load(std::memory_order_relaxed);
+        count += static_cast<size_t>(std::min<uint64_t>(written - begin, RING_SIZE));
+    }
+    return count;
+}
+
+void Clear() {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+        buffer->begin.store(buffer->written.load(std::memory_order_acquire),
+                            std::memory_order_relaxed);
+    }
+}
+
+void WriteChromeTrace(std::ostream& out) {
+    Registry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() -> const char* {
+        const char* result = first ? "\n" : ",\n";
+        first = false;
+        return result;
+    };
+
+    for (const auto& buffer : registry.buffers) {
+        out << separator()
+            << std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+                           R"("args":{{"name":"{}"}}}})",
+                           buffer->id, EscapeJson(buffer->name));
+
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t begin = std::max(buffer->begin.load(std::memory_order_relaxed),
+                                        written > RING_SIZE ? written - RING_SIZE : 0);
+        for (uint64_t i = begin; i < written; ++i) {
+            const Event& event = buffer->events[i % RING_SIZE];
+            const int64_t start = event.start.load(std::memory_order_relaxed);
+            const int64_t end = event.end.load(std::memory_order_relaxed);
+            const uint64_t async_id = event.async_id.load(std::memory_order_relaxed);
+            const std::string name = EscapeJson(event.name.load(std::memory_order_relaxed));
+            const std::string category =
+                EscapeJson(event.category.load(std::memory_order_relaxed));
+            // Время в микросекундах, как требует формат
+            if (async_id == 0) {
+                out << separator()
+                    << std::format(
+                           R"({{"name":"{}","cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},)"
+                           R"("pid":1,"tid":{}}})",
+                           name, category, static_cast<double>(start) / 1000,
+                           static_cast<double>(end - start) / 1000, buffer->id);
+                continue;
+            }
+            // Начало и конец асинхронного участка связаны категорией и номером
+            for (const auto& [phase, time] : {std::pair{'b', start}, std::pair{'e', end}}) {
+                out << separator()
+                    << std::format(R"({{"name":"{}","cat":"{}","ph":"{}","ts":{:.3f},)"
+                                   R"("pid":1,"tid":{},"id":{}}})",
+                                   name, category, phase, static_cast<double>(time) / 1000,
+                                   buffer->id, async_id);
+            }
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void WriteChromeTraceFile(const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error(std::format("Cannot open trace file: {}", path));
+    }
+    WriteChromeTrace(file);
+    if (!file.flush()) {
+        throw std::runtime_error(std::format("Cannot write trace file: {}", path));
+    }
+}
+
+TraceSession::TraceSession(std::string path) : path_(std::move(path)) {
+    if (path_.empty()) {
+        return;
+    }
+    if (!COMPILED_IN) {
+        std::cerr << "Tracing is disabled at compile time, " << path_ << " will not be written"
+                  << std::endl;
+        path_.clear();
+        return;
+    }
+    Enable();
+}
+
+TraceSession::~TraceSession() {
+    if (!IsActive()) {
+        return;
+    }
+    try {
+        Dump();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
+void TraceSession::Dump() const { WriteChromeTraceFile(path_); }
+
+}  // namespace trace
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace trace {
+
+// Сколько последних событий хранит каждый поток. Старые события затираются новыми
+inline constexpr size_t RING_SIZE = 8192;
+
+// Сборка с -DTRACING=OFF: спаны сводятся к пустым объектам, которые вырезает компилятор
+#ifdef CHECKLIST_NO_TRACING
+inline constexpr bool COMPILED_IN = false;
+#else
+inline constexpr bool COMPILED_IN = true;
+#endif
+
+namespace detail {
+
+extern std::atomic<bool> enabled;
+
+// Наносекунды steady_clock
+int64_t Now();
+// async_id 0 - участок потока, иначе асинхронный участок с этим номером
+void Record(const char* category, const char* name, int64_t start, int64_t end,
+            uint64_t async_id = 0);
+// Номер для следующего асинхронного участка, не 0
+uint64_t NextAsyncId();
+
+}  // namespace detail
+
+inline bool IsEnabled() {
+    return COMPILED_IN && detail::enabled.load(std::memory_order_relaxed);
+}
+
+void Enable(bool enabled = true);
+
+// Имя текущего потока в трассе, по умолчанию "thread N"
+void SetThreadName(std::string name);
+
+// Участок кода от создания до End() или удаления. Категория и имя не копируются
+// и должны жить до записи трассы - обычно это строковые литералы.
+// При выключенной трассировке стоит одну проверку флага
+class Span {
+ public:
+    Span(const char* category, const char* name) {
+        if (IsEnabled()) {
+            category_ = category;
+            name_ = name;
+            start_ = detail::Now();
+        }
+    }
+    ~Span() { End(); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    void End() {
+        if (name_ != nullptr) {
+            detail::Record(category_, name_, start_, detail::Now());
+            name_ = nullptr;
+        }
+    }
+
+ private:
+    const char* category_ = nullptr;
+    const char* name_ = nullptr;
+    int64_t start_ = 0;
+};
+
+// Участок корутины, который продолжается после co_await. Пока корутина ждет,
+// поток выполняет другие корутины, и их участки пересекались бы без вложения.
+// Поэтому такой участок пишется парой асинхронных событий со своим номером
+// и в трассе лежит на отдельной дорожке. Для кода без co_await нужен Span
+class AsyncSpan {
+ public:
+    AsyncSpan(const char* category, const char* name) {
+        if (IsEnabled()) {
+            category_ = category;
+            name_ = name;
+            start_ = detail::Now();
+            id_ = detail::NextAsyncId();
+        }
+    }
+    ~AsyncSpan() { End(); }
+
+    AsyncSpan(const AsyncSpan&) = delete;
+    AsyncSpan& operator=(const AsyncSpan&) = delete;
+
+    void End() {
+        if (name_ != nullptr) {
+            detail::Record(category_, name_, start_, detail::Now(), id_);
+            name_ = nullptr;
+        }
+    }
+
+ private:
+    const char* category_ = nullptr;
+    const char* name_ = nullptr;
+    int64_t start_ = 0;
+    uint64_t id_ = 0;
+};
+
+// Число событий во всех буферах
+size_t GetEventCount();
+// Удаляет накопленные события
+void Clear();
+
+// Трасса в формате Chrome Trace Event: открывается в chrome://tracing и ui.perfetto.dev.
+// Запись не останавливает потоки, события, затертые во время записи, могут потеряться
+void WriteChromeTrace(std::ostream& out);
+// То же в файл. Ошибки бросаются
+void WriteChromeTraceFile(const std::string& path);
+
+// Трассировка на время работы программы: с непустым путем включается сразу,
+// а при удалении записывает события в файл
+class TraceSession {
+ public:
+    explicit TraceSession(std::string path);
+    ~TraceSession();
+
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+
+    bool IsActive() const { return !path_.empty(); }
+    const std::string& GetPath() const { return path_; }
+
+    // Записывает события, накопленные к этому моменту, трассировка продолжается
+    void Dump() const;
+
+ private:
+    std::string path_;
+};
+
+}  // namespace trace
@@ -0,0 +1,461 @@
+#include "Bot.hpp"
+#include "ConnectionPool.hpp"
+#include "LoadGenerator.hpp"
+#include "MockApiServer.hpp"
+#include "UpdateDecoder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/use_future.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+using namespace std::chrono_literals;
+namespace net = boost::asio;
+
+// Тесты для Summarize
+TEST(SummarizeTest, NearestRankPercentiles) {
+    std::vector<Clock::duration> samples;
+    for (int i = 100; i >= 1; --i) {
+        samples.push_back(std::chrono::milliseconds(i));
+    }
+
+    const LatencyStats stats = Summarize(samples);
+    EXPECT_EQ(stats.min, 1ms);
+    EXPECT_EQ(stats.p50, 50ms);
+    EXPECT_EQ(stats.p90, 90ms);
+    EXPECT_EQ(stats.p99, 99ms);
+    EXPECT_EQ(stats.max, 100ms);
+    EXPECT_EQ(stats.mean, 50500us);
+
+    EXPECT_EQ(Summarize({}).p99, Clock::duration::zero());
+    EXPECT_EQ(Summarize({7ms}).p50, 7ms);
+}
+
+MockApiOptions AnyPortOptions() {
+    MockApiOptions options;
+    options.port = 0;
+    return options;
+}
+
+// Сервер на свободном порту, клиент - пул соединений бота по обычному HTTP
+class MockApiServerTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        server_.Listen();
+        server_.SetSendHandler([this](long chat_id, const std::string& text) {
+            std::lock_guard lock(mutex_);
+            sent_.emplace_back(chat_id, text);
+        });
+        pool_ = std::make_unique<bot::ConnectionPool>(
+            ioc_.get_executor(), bot::ApiEndpoint::Parse(server_.GetUrl()));
+        net::co_spawn(ioc_, server_.Run(), net::detached);
+        thread_ = std::thread([this] { ioc_.run(); });
+    }
+
+    void TearDown() override {
+        ioc_.stop();
+        thread_.join();
+    }
+
+    bot::HttpResponse Post(const std::string& method, const std::string& body) {
+        return net::co_spawn(ioc_, pool_->Post("/bottest/" + method, body), net::use_future).get();
+    }
+
+    net::io_context ioc_;
+    MockApiServer server_{ioc_.get_executor(), AnyPortOptions()};
+    std::unique_ptr<bot::ConnectionPool> pool_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<std::pair<long, std::string>> sent_;
+};
+
+TEST_F(MockApiServerTest, LongPollReturnsPushedMessages) {
+    // Сообщение приходит, пока getUpdates ждет
+    std::thread pusher([this] {
+        std::this_thread::sleep_for(50ms);
+        server_.PushMessage(42, "/list");
+    });
+    const Clock::time_point start = Clock::now();
+    const bot::HttpResponse first = Post("getUpdates", R"({"offset":0,"timeout":10})");
+    pusher.join();
+    EXPECT_LT(Clock::now() - start, 5s);
+
+    std::vector<bot::Update> updates;
+    ASSERT_TRUE(bot::DecodeUpdates(first.body, updates));
+    ASSERT_EQ(updates.size(), 1u);
+    ASSERT_TRUE(updates[0].message.has_value());
+    EXPECT_EQ(updates[0].message->GetChatId(), 42);
+    EXPECT_EQ(updates[0].message->GetText(), "/list");
+
+    // Без подтверждения обновление выдается снова, смещение его убирает
+    updates.clear();
+    ASSERT_TRUE(bot::DecodeUpdates(Post("getUpdates", R"({"offset":0})").body, updates));
+    EXPECT_EQ(updates.size(), 1u);
+
+    const std::string confirm = R"({"offset":)" + std::to_string(updates[0].id + 1) + "}";
+    updates.clear();
+    ASSERT_TRUE(bot::DecodeUpdates(Post("getUpdates", confirm).body, updates));
+    EXPECT_TRUE(updates.empty());
+    EXPECT_EQ(server_.GetPollCount(), 3u);
+}
+
+TEST_F(MockApiServerTest, SendMessageCallsHandler) {
+    const bot::HttpResponse response = Post("sendMessage", R"({"chat_id":7,"text":"привет"})");
+    EXPECT_EQ(response.status, 200u);
+    EXPECT_NE(response.body.find(R"("ok":true)"), std::string::npos);
+
+    EXPECT_EQ(Post("sendMessage", R"({"text":"no chat"})").status, 400u);
+    EXPECT_EQ(Post("deleteWebhook", "{}").status, 200u);
+
+    std::lock_guard lock(mutex_);
+    ASSERT_EQ(sent_.size(), 1u);
+    EXPECT_EQ(sent_[0], (std::pair<long, std::string>{7, "привет"}));
+    EXPECT_EQ(server_.GetSentCount(), 1u);
+}
+
+// Тесты для ConnectionPool: повторное использование, устаревание и повтор запроса
+class ConnectionPoolTest : public ::testing::Test {
+ protected:
+    void Start(const MockApiOptions& options,
+               bot::ConnectionPool::Duration idle_timeout =
+                   bot::ConnectionPool::DEFAULT_IDLE_TIMEOUT) {
+        server_.emplace(ioc_.get_executor(), options);
+        server_->Listen();
+        pool_ = std::make_unique<bot::ConnectionPool>(
+            ioc_.get_executor(), bot::ApiEndpoint::Parse(server_->GetUrl()),
+            bot::ConnectionPool::DEFAULT_MAX_IDLE, idle_timeout);
+        net::co_spawn(ioc_, server_->Run(), net::detached);
+        thread_ = std::thread([this] { ioc_.run(); });
+    }
+
+    void TearDown() override {
+        ioc_.stop();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    bot::HttpResponse Send(const std::string& text,
+                           bot::ConnectionPool::Duration timeout =
+                               bot::ConnectionPool::DEFAULT_TIMEOUT) {
+        const std::string body = R"({"chat_id":1,"text":")" + text + R"("})";
+        return net::co_spawn(ioc_, pool_->Post("/bottest/sendMessage", body, timeout),
+                             net::use_future)
+            .get();
+    }
+
+    net::io_context ioc_;
+    std::optional<MockApiServer> server_;
+    std::unique_ptr<bot::ConnectionPool> pool_;
+    std::thread thread_;
+};
+
+TEST_F(ConnectionPoolTest, ReusesKeepAliveConnection) {
+    Start(AnyPortOptions());
+    EXPECT_EQ(Send("first").status, 200u);
+    EXPECT_EQ(Send("second").status, 200u);
+    EXPECT_EQ(server_->GetConnectionCount(), 1u);
+    EXPECT_EQ(pool_->GetIdleCount(), 1u);
+    EXPECT_EQ(pool_->GetConnectTime().Collect().count, 1u);
+}
+
+TEST_F(ConnectionPoolTest, DropsExpiredConnection) {
+    Start(AnyPortOptions(), 50ms);
+    EXPECT_EQ(Send("first").status, 200u);
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(Send("second").status, 200u);
+    EXPECT_EQ(server_->GetConnectionCount(), 2u);
+    EXPECT_EQ(server_->GetSentCount(), 2u);
+}
+
+TEST_F(ConnectionPoolTest, RetriesWhenServerClosedIdleConnection) {
+    // Сервер закрывает соединение раньше, чем пул считает его устаревшим
+    MockApiOptions options = AnyPortOptions();
+    options.idle_timeout = 50ms;
+    Start(options);
+    EXPECT_EQ(Send("first").status, 200u);
+    std::this_thread::sleep_for(200ms);
+    EXPECT_EQ(Send("second").status, 200u);
+    EXPECT_EQ(server_->GetConnectionCount(), 2u);
+    EXPECT_EQ(server_->GetSentCount(), 2u);
+}
+
+TEST_F(ConnectionPoolTest, DoesNotRetryAfterResponseTimeout) {
+    MockApiOptions options = AnyPortOptions();
+    options.latency = 300ms;
+    Start(options);
+    EXPECT_EQ(Send("first").status, 200u);
+
+    // Запрос дошел до сервера: повтор отправил бы сообщение второй раз
+    EXPECT_THROW(Send("second", 100ms), boost::system::system_error);
+    std::this_thread::sleep_for(500ms);
+    EXPECT_EQ(server_->GetSentCount(), 2u);
+    EXPECT_EQ(server_->GetConnectionCount(), 1u);
+}
+
+// Бот целиком против локального сервера: прием обновления, обработка и отправка ответа
+TEST(BotEngineTest, RepliesAndRetriesAfterTooManyRequests) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "engine_test";
+    std::filesystem::remove_all(dir);
+
+    net::io_context ioc;
+    MockApiServer server(ioc.get_executor(), AnyPortOptions());
+    server.Listen();
+    std::mutex mutex;
+    std::condition_variable replied;
+    std::vector<std::pair<long, std::string>> sent;
+    server.SetSendHandler([&](long chat_id, const std::string& text) {
+        std::lock_guard lock(mutex);
+        sent.emplace_back(chat_id, text);
+        replied.notify_all();
+    });
+    // Первая отправка получит 429, бот должен выждать retry_after и повторить
+    server.RejectSends(1, 1s);
+    net::co_spawn(ioc, server.Run(), net::detached);
+    std::thread server_thread([&ioc] { ioc.run(); });
+
+    bot::BotOptions bot_options;
+    bot_options.api_url = server.GetUrl();
+    bot_options.storage_dir = dir.string();
+    bot_options.worker_threads = 1;
+    bot::Bot bot("test", bot_options);
+    std::thread bot_thread([&bot] { bot.Start(); });
+
+    const Clock::time_point start = Clock::now();
+    server.PushMessage(5, "/add milk");
+    {
+        std::unique_lock lock(mutex);
+        EXPECT_TRUE(replied.wait_for(lock, 10s, [&sent] { return !sent.empty(); }));
+    }
+    const Clock::duration elapsed = Clock::now() - start;
+    const std::string metrics = bot.RenderMetrics();
+    bot.Stop();
+    bot_thread.join();
+    ioc.stop();
+    server_thread.join();
+
+    std::lock_guard lock(mutex);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0], (std::pair<long, std::string>{5, "Задача добавлена успешно!"}));
+    EXPECT_EQ(server.GetRejectedCount(), 1u);
+    EXPECT_GE(elapsed, 1s);
+    EXPECT_NE(metrics.find("tg_bot_rate_limited_total 1\n"), std::string::npos);
+    EXPECT_NE(metrics.find("tg_bot_command_seconds_count{command=\"add\"} 1\n"),
+              std::string::npos);
+    std::filesystem::remove_all(dir);
+}
+
+// Ответ, поставленный в очередь во время отправки предыдущего, уходит после него
+TEST(BotEngineTest, KeepsReplyOrderWhileSending) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "engine_order_test";
+    std::filesystem::remove_all(dir);
+
+    net::io_context ioc;
+    MockApiServer server(ioc.get_executor(), AnyPortOptions());
+    server.Listen();
+    std::mutex mutex;
+    std::condition_variable replied;
+    std::vector<std::pair<long, std::string>> sent;
+    server.SetSendHandler([&](long chat_id, const std::string& text) {
+        std::lock_guard lock(mutex);
+        sent.emplace_back(chat_id, text);
+        replied.notify_all();
+    });
+    // Первый ответ ждет повтора после 429, пока приходит вторая команда
+    server.RejectSends(1, 1s);
+    net::co_spawn(ioc, server.Run(), net::detached);
+    std::thread server_thread([&ioc] { ioc.run(); });
+
+    bot::BotOptions bot_options;
+    bot_options.api_url = server.GetUrl();
+    bot_options.storage_dir = dir.string();
+    bot_options.worker_threads = 1;
+    bot::Bot bot("test", bot_options);
+    std::thread bot_thread([&bot] { bot.Start(); });
+
+    server.PushMessage(5, "/add milk");
+    const Clock::time_point deadline = Clock::now() + 10s;
+    while (server.GetRejectedCount() == 0 && Clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+    }
+    server.PushMessage(5, "/list");
+    {
+        std::unique_lock lock(mutex);
+        EXPECT_TRUE(replied.wait_for(lock, 10s, [&sent] { return sent.size() >= 2; }));
+    }
+    // Лишний отправитель успел бы послать пустое сообщение
+    std::this_thread::sleep_for(200ms);
+    bot.Stop();
+    bot_thread.join();
+    ioc.stop();
+    server_thread.join();
+
+    std::lock_guard lock(mutex);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[0], (std::pair<long, std::string>{5, "Задача добавлена успешно!"}));
+    EXPECT_EQ(sent[1].first, 5);
+    EXPECT_NE(sent[1].second.find("0. [ ] milk"), std::string::npos);
+    std::filesystem::remove_all(dir);
+}
+
+// Остановка дожидается ответа на уже обработанную команду
+TEST(BotEngineTest, SendsQueuedReplyBeforeStopping) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "engine_stop_test";
+    std::filesystem::remove_all(dir);
+
+    net::io_context ioc;
+    MockApiServer server(ioc.get_executor(), AnyPortOptions());
+    server.Listen();
+    std::mutex mutex;
+    std::vector<std::pair<long, std::string>> sent;
+    server.SetSendHandler([&](long chat_id, const std::string& text) {
+        std::lock_guard lock(mutex);
+        sent.emplace_back(chat_id, text);
+    });
+    // Ответ еще ждет повтора после 429, когда бота останавливают
+    server.RejectSends(1, 1s);
+    net::co_spawn(ioc, server.Run(), net::detached);
+    std::thread server_thread([&ioc] { ioc.run(); });
+
+    bot::BotOptions bot_options;
+    bot_options.api_url = server.GetUrl();
+    bot_options.storage_dir = dir.string();
+    bot_options.worker_threads = 1;
+    bot::Bot bot("test", bot_options);
+    std::thread bot_thread([&bot] { bot.Start(); });
+
+    server.PushMessage(5, "/add milk");
+    const Clock::time_point deadline = Clock::now() + 10s;
+    while (server.GetRejectedCount() == 0 && Clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+    }
+    bot.Stop();
+    bot_thread.join();
+    ioc.stop();
+    server_thread.join();
+
+    std::lock_guard lock(mutex);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0], (std::pair<long, std::string>{5, "Задача добавлена успешно!"}));
+    std::filesystem::remove_all(dir);
+}
+
+// Исключение в команде плагина не задерживает сохраняемое смещение и остановку
+TEST(BotEngineTest, CompletesUpdateAfterThrowingPlugin) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "engine_plugin_test";
+    std::filesystem::remove_all(dir);
+
+    net::io_context ioc;
+    MockApiServer server(ioc.get_executor(), AnyPortOptions());
+    server.Listen();
+    std::mutex mutex;
+    std::condition_variable replied;
+    std::vector<std::pair<long, std::string>> sent;
+    server.SetSendHandler([&](long chat_id, const std::string& text) {
+        std::lock_guard lock(mutex);
+        sent.emplace_back(chat_id, text);
+        replied.notify_all();
+    });
+    net::co_spawn(ioc, server.Run(), net::detached);
+    std::thread server_thread([&ioc] { ioc.run(); });
+
+    bot::BotOptions bot_options;
+    bot_options.api_url = server.GetUrl();
+    bot_options.storage_dir = dir.string();
+    bot_options.worker_threads = 1;
+    bot::Bot bot("test", bot_options);
+    bot.GetCommandHandler().RegisterCommand(
+        "boom", "Всегда падает",
+        [](const bot::Message&, bot::ChatStore::Handle&, bot::CommandHandler::Reply) {
+            throw std::runtime_error("boom");
+        });
+    std::thread bot_thread([&bot] { bot.Start(); });
+
+    server.PushMessage(5, "/boom");
+    const long last = server.PushMessage(5, "/add milk");
+    {
+        std::unique_lock lock(mutex);
+        EXPECT_TRUE(replied.wait_for(lock, 10s, [&sent] { return !sent.empty(); }));
+    }
+    const Clock::time_point stop = Clock::now();
+    bot.Stop();
+    bot_thread.join();
+    const Clock::duration stopping = Clock::now() - stop;
+    ioc.stop();
+    server_thread.join();
+
+    EXPECT_LT(stopping, bot::Bot::SHUTDOWN_TIMEOUT);
+    EXPECT_EQ(bot::ChatStore(dir).LoadOffset(), last + 1);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(BotEngineTest, RejectsZeroSendRate) {
+    bot::BotOptions options;
+    options.api_url = "http://127.0.0.1:1";
+    options.storage_dir = (std::filesystem::temp_directory_path() / "engine_test").string();
+    options.send_limits.chat_per_second = 0;
+    EXPECT_THROW(bot::Bot("test", options), std::invalid_argument);
+}
+
+TEST(LoadGeneratorTest, MeasuresRepliesFromBot) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "load_test";
+    std::filesystem::remove_all(dir);
+
+    net::io_context ioc;
+    MockApiServer server(ioc.get_executor(), AnyPortOptions());
+    server.Listen();
+    LoadOptions options;
+    options.chats = 3;
+    options.commands_per_chat = 4;
+    options.timeout = 30s;
+    LoadGenerator generator(server, options);
+    net::co_spawn(ioc, server.Run(), net::detached);
+    std::thread server_thread([&ioc] { ioc.run(); });
+
+    bot::BotOptions bot_options;
+    bot_options.api_url = server.GetUrl();
+    bot_options.storage_dir = dir.string();
+    bot_options.worker_threads = 2;
+    bot::Bot bot("test", bot_options);
+    std::thread bot_thread([&bot] { bot.Start(); });
+
+    const LoadReport report = generator.Run();
+    const std::string metrics = bot.RenderMetrics();
+    bot.Stop();
+    bot_thread.join();
+    ioc.stop();
+    server_thread.join();
+
+    EXPECT_EQ(report.commands, 12u);
+    EXPECT_EQ(report.replies, 12u);
+    EXPECT_GT(report.latency.p50, Clock::duration::zero());
+    EXPECT_LE(report.latency.p50, report.latency.max);
+    EXPECT_GT(report.GetThroughput(), 0);
+    // Поровну /add и /list, очередь ответов пуста. Ответ на последний sendMessage
+    // бот может еще не получить, поэтому счетчик отправленных не проверяем
+    EXPECT_NE(metrics.find("tg_bot_command_seconds_count{command=\"add\"} 6\n"),
+              std::string::npos);
+    EXPECT_NE(metrics.find("tg_bot_command_seconds_count{command=\"list\"} 6\n"),
+              std::string::npos);
+    EXPECT_NE(metrics.find("tg_bot_outbox_messages 0\n"), std::string::npos);
+    // Каждый чат добавил две задачи в свой список
+    EXPECT_TRUE(std::filesystem::exists(dir / "1.json"));
+    std::filesystem::remove_all(dir);
+}
+
+}  // namespace bench
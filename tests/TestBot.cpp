@@ -0,0 +1,962 @@
+#include "Backoff.hpp"
+#include "ChatStore.hpp"
+#include "CommandHandler.hpp"
+#include "ConnectionPool.hpp"
+#include "DnsCache.hpp"
+#include "ListCache.hpp"
+#include "Message.hpp"
+#include "Metrics.hpp"
+#include "MetricsServer.hpp"
+#include "TokenBucket.hpp"
+#include "UpdateDecoder.hpp"
+#include "UpdateQueue.hpp"
+#include "WebhookServer.hpp"
+#include "WorkerPool.hpp"
+#include "WriteBehind.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bot {
+
+using namespace std::chrono_literals;
+using json = nlohmann::json;
+
+// Тесты для Backoff
+TEST(BackoffTest, GrowsExponentiallyWithJitter) {
+    Backoff backoff(100ms, 10s);
+
+    Backoff::Duration expected = 100ms;
+    for (int i = 0; i < 5; ++i) {
+        const Backoff::Duration delay = backoff.Next();
+        EXPECT_GE(delay, expected / 2);
+        EXPECT_LE(delay, expected);
+        expected *= 2;
+    }
+    EXPECT_EQ(backoff.GetFailures(), 5u);
+}
+
+TEST(BackoffTest, CappedAtMax) {
+    Backoff backoff(100ms, 1s);
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_LE(backoff.Next(), 1s);
+    }
+    EXPECT_GE(backoff.Next(), 500ms);
+}
+
+TEST(BackoffTest, ResetStartsOver) {
+    Backoff backoff(100ms, 10s);
+    for (int i = 0; i < 10; ++i) {
+        backoff.Next();
+    }
+
+    backoff.Reset();
+    EXPECT_EQ(backoff.GetFailures(), 0u);
+    EXPECT_LE(backoff.Next(), 100ms);
+}
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+// Webhook сервер на локальном порту и клиент, который шлет обновления вместо Telegram
+class WebhookTest : public ::testing::Test {
+ protected:
+    static constexpr const char* SECRET = "test-secret_123";
+
+    void SetUp() override {
+        WebhookOptions options;
+        options.public_url = "https://example.com/webhook";
+        options.listen_address = "127.0.0.1";
+        options.port = 0;
+        options.secret_token = SECRET;
+
+        auto handler = [this](Update update) {
+            std::lock_guard lock(mutex_);
+            received_.push_back(std::move(update));
+        };
+        server_ = std::make_unique<WebhookServer>(ioc_.get_executor(), options, handler);
+        server_->Listen();
+        net::co_spawn(ioc_, server_->Run(), net::detached);
+        thread_ = std::thread([this] { ioc_.run(); });
+    }
+
+    void TearDown() override {
+        net::post(ioc_, [this] { server_->Stop(); });
+        thread_.join();
+    }
+
+    http::response<http::string_body> Send(http::verb method, const std::string& target,
+                                           const std::string& body, const char* secret) {
+        net::io_context client_ioc;
+        beast::tcp_stream stream(client_ioc);
+        stream.connect(net::ip::tcp::endpoint(net::ip::make_address("127.0.0.1"),
+                                              server_->GetPort()));
+
+        http::request<http::string_body> request{method, target, 11};
+        request.set(http::field::host, "127.0.0.1");
+        request.set(http::field::content_type, "application/json");
+        if (secret != nullptr) {
+            request.set(WebhookServer::SECRET_HEADER, secret);
+        }
+        request.body() = body;
+        request.prepare_payload();
+        http::write(stream, request);
+
+        beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        http::read(stream, buffer, response);
+        return response;
+    }
+
+    std::vector<Update> GetReceived() {
+        std::lock_guard lock(mutex_);
+        return received_;
+    }
+
+    net::io_context ioc_;
+    std::unique_ptr<WebhookServer> server_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<Update> received_;
+};
+
+TEST_F(WebhookTest, AcceptsUpdateWithSecret) {
+    const std::string update =
+        R"({"update_id":7,"message":{"message_id":1,"chat":{"id":42},"text":"/list"}})";
+    const auto response = Send(http::verb::post, "/webhook", update, SECRET);
+
+    EXPECT_EQ(response.result(), http::status::ok);
+    const std::vector<Update> received = GetReceived();
+    ASSERT_EQ(received.size(), 1u);
+    EXPECT_EQ(received[0].id, 7);
+    ASSERT_TRUE(received[0].message.has_value());
+    EXPECT_EQ(received[0].message->GetChatId(), 42);
+}
+
+TEST_F(WebhookTest, RejectsInvalidRequests) {
+    const std::string update = R"({"update_id":1})";
+
+    EXPECT_EQ(Send(http::verb::post, "/webhook", update, nullptr).result(),
+              http::status::unauthorized);
+    EXPECT_EQ(Send(http::verb::post, "/webhook", update, "wrong-secret").result(),
+              http::status::unauthorized);
+    EXPECT_EQ(Send(http::verb::post, "/other", update, SECRET).result(), http::status::not_found);
+    EXPECT_EQ(Send(http::verb::get, "/webhook", "", SECRET).result(),
+              http::status::method_not_allowed);
+    EXPECT_EQ(Send(http::verb::post, "/webhook", "not json", SECRET).result(),
+              http::status::bad_request);
+
+    EXPECT_TRUE(GetReceived().empty());
+}
+
+TEST_F(WebhookTest, RefusesUpdatesAfterStop) {
+    // Соединение Telegram, открытое до остановки, не должно получить 200
+    HttpRequest request{http::verb::post, "/webhook", 11};
+    request.set(WebhookServer::SECRET_HEADER, SECRET);
+    request.body() =
+        R"({"update_id":8,"message":{"message_id":1,"chat":{"id":42},"text":"/list"}})";
+    std::promise<HttpServerResponse> handled;
+    net::post(ioc_, [&] {
+        server_->Stop();
+        handled.set_value(server_->HandleRequest(request));
+    });
+    const HttpServerResponse response = handled.get_future().get();
+
+    EXPECT_EQ(response.result(), http::status::service_unavailable);
+    EXPECT_FALSE(response.keep_alive());
+    EXPECT_TRUE(GetReceived().empty());
+}
+
+TEST(WebhookOptionsTest, GeneratesSecretToken) {
+    const std::string token = GenerateSecretToken();
+    EXPECT_EQ(token.size(), 32u);
+    EXPECT_EQ(token.find_first_not_of(
+                  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-"),
+              std::string::npos);
+    EXPECT_NE(token, GenerateSecretToken());
+}
+
+// Тесты для UpdateQueue
+TEST(UpdateQueueTest, PopWaitsForPush) {
+    net::io_context ioc;
+    UpdateQueue queue(ioc.get_executor());
+    std::vector<int> popped;
+
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            for (int i = 0; i < 3; ++i) {
+                const Update update = co_await queue.Pop();
+                popped.push_back(static_cast<int>(update.id));
+            }
+        },
+        net::detached);
+
+    queue.Push(Update{1, std::nullopt, std::nullopt});
+    net::post(ioc, [&] {
+        queue.Push(Update{2, std::nullopt, std::nullopt});
+        queue.Push(Update{3, std::nullopt, std::nullopt});
+    });
+    ioc.run();
+
+    EXPECT_EQ(popped, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(queue.Size(), 0u);
+}
+
+// Тесты для UpdateDecoder
+TEST(UpdateDecoderTest, ExtractsMessageFields) {
+    const std::string body = R"({"ok":true,"result":[
+        {"update_id":10,"message":{"message_id":5,"from":{"id":1,"is_bot":false},
+         "chat":{"id":-100,"type":"group","title":"t"},"date":1,"text":"/add milk",
+         "entities":[{"offset":0,"length":4,"type":"bot_command"}]}},
+        {"update_id":11,"edited_message":{"message_id":6,"chat":{"id":3},"text":"x"}},
+        {"update_id":12,"message":{"message_id":7,"chat":{"id":4},"text":5}}]})";
+
+    std::vector<Update> updates;
+    ASSERT_TRUE(DecodeUpdates(body, updates));
+    ASSERT_EQ(updates.size(), 3u);
+
+    EXPECT_EQ(updates[0].id, 10);
+    ASSERT_TRUE(updates[0].message.has_value());
+    EXPECT_EQ(updates[0].message->GetId(), 5);
+    EXPECT_EQ(updates[0].message->GetChatId(), -100);
+    EXPECT_EQ(updates[0].message->GetText(), "/add milk");
+    EXPECT_EQ(updates[0].message->GetCommand(), "add");
+    EXPECT_EQ(updates[0].message->GetUpdateId(), 10);
+
+    // Другие типы обновлений и сообщения с полями неверного типа пропускаются,
+    // но update_id все равно нужен для смещения
+    EXPECT_EQ(updates[1].id, 11);
+    EXPECT_FALSE(updates[1].message.has_value());
+    EXPECT_EQ(updates[2].id, 12);
+    EXPECT_FALSE(updates[2].message.has_value());
+}
+
+TEST(UpdateDecoderTest, ExtractsCallbackQuery) {
+    const std::string body = R"({"ok":true,"result":[
+        {"update_id":20,"callback_query":{"id":"cb1","from":{"id":1,"is_bot":false},
+         "message":{"message_id":9,"chat":{"id":-5},"text":"Список задач:\n0. [ ] milk",
+          "reply_markup":{"inline_keyboard":[[{"text":"[ ] 0","callback_data":"done:1:0"}]]}},
+         "chat_instance":"1","data":"done:1:0"}},
+        {"update_id":21,"callback_query":{"id":"cb2","inline_message_id":"x","data":"list:1"}}]})";
+
+    std::vector<Update> updates;
+    ASSERT_TRUE(DecodeUpdates(body, updates));
+    ASSERT_EQ(updates.size(), 2u);
+
+    EXPECT_FALSE(updates[0].message.has_value());
+    ASSERT_TRUE(updates[0].callback_query.has_value());
+    const CallbackQuery& query = *updates[0].callback_query;
+    EXPECT_EQ(query.id, "cb1");
+    EXPECT_EQ(query.chat_id, -5);
+    EXPECT_EQ(query.message_id, 9);
+    EXPECT_EQ(query.update_id, 20);
+    EXPECT_EQ(query.data, "done:1:0");
+
+    // Кнопка под сообщением, отправленным не ботом в чат: править нечего
+    EXPECT_EQ(updates[1].id, 21);
+    EXPECT_FALSE(updates[1].callback_query.has_value());
+}
+
+TEST(UpdateDecoderTest, ReportsErrorsAndAppends) {
+    std::vector<Update> updates{Update{1, std::nullopt, std::nullopt}};
+    EXPECT_FALSE(DecodeUpdates(R"({"ok":false,"error_code":409,"description":"Conflict"})",
+                               updates));
+    EXPECT_TRUE(DecodeUpdates(R"({"ok":true,"result":[{"update_id":2}]})", updates));
+    ASSERT_EQ(updates.size(), 2u);
+    EXPECT_EQ(updates[1].id, 2);
+
+    EXPECT_THROW(DecodeUpdates("{\"ok\":tru", updates), std::runtime_error);
+}
+
+TEST(UpdateDecoderTest, DecodesSingleUpdate) {
+    const auto update =
+        DecodeUpdate(R"({"update_id":7,"message":{"message_id":1,"chat":{"id":42},"text":"hi"}})");
+    ASSERT_TRUE(update.has_value());
+    EXPECT_EQ(update->id, 7);
+    ASSERT_TRUE(update->message.has_value());
+    EXPECT_FALSE(update->message->IsCommand());
+
+    EXPECT_FALSE(DecodeUpdate("not json").has_value());
+    EXPECT_FALSE(DecodeUpdate("[1, 2]").has_value());
+}
+
+// Тесты для DnsCache
+TEST(DnsCacheTest, ServesCachedAddressesAndRefreshesInBackground) {
+    net::io_context ioc;
+    DnsCache cache(ioc.get_executor(), "127.0.0.1", "443");
+    std::vector<size_t> sizes;
+
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            sizes.push_back((co_await cache.Resolve()).size());
+            sizes.push_back((co_await cache.Resolve()).size());
+            // Устаревшие адреса отдаются сразу, обновление идет в фоне
+            cache.Invalidate();
+            sizes.push_back((co_await cache.Resolve()).size());
+        },
+        net::detached);
+    ioc.run();
+
+    EXPECT_EQ(sizes, (std::vector<size_t>{1, 1, 1}));
+    EXPECT_TRUE(cache.HasAddresses());
+    EXPECT_EQ(cache.GetLookupCount(), 2u);
+}
+
+// Тесты для ApiEndpoint
+TEST(ApiEndpointTest, ParsesSchemePortAndPath) {
+    const ApiEndpoint telegram = ApiEndpoint::Parse("https://api.telegram.org");
+    EXPECT_TRUE(telegram.use_tls);
+    EXPECT_EQ(telegram.host, "api.telegram.org");
+    EXPECT_EQ(telegram.port, "443");
+    EXPECT_EQ(telegram.path, "");
+
+    const ApiEndpoint local = ApiEndpoint::Parse("http://127.0.0.1:8081/api/");
+    EXPECT_FALSE(local.use_tls);
+    EXPECT_EQ(local.host, "127.0.0.1");
+    EXPECT_EQ(local.port, "8081");
+    EXPECT_EQ(local.path, "/api");
+
+    const ApiEndpoint ipv6 = ApiEndpoint::Parse("http://[::1]");
+    EXPECT_EQ(ipv6.host, "::1");
+    EXPECT_EQ(ipv6.port, "80");
+}
+
+TEST(ApiEndpointTest, RejectsInvalidUrls) {
+    EXPECT_THROW(ApiEndpoint::Parse("ftp://example.com"), std::invalid_argument);
+    EXPECT_THROW(ApiEndpoint::Parse("api.telegram.org"), std::invalid_argument);
+    EXPECT_THROW(ApiEndpoint::Parse("https://"), std::invalid_argument);
+    EXPECT_THROW(ApiEndpoint::Parse("http://localhost:port"), std::invalid_argument);
+}
+
+// Тесты для WorkerPool
+TEST(WorkerPoolTest, KeepsOrderWithinKey) {
+    std::mutex mutex;
+    std::vector<int> first;
+    std::vector<int> second;
+    {
+        WorkerPool pool(4);
+        for (int i = 0; i < 100; ++i) {
+            pool.Submit(1, [&, i] {
+                std::lock_guard lock(mutex);
+                first.push_back(i);
+            });
+            pool.Submit(2, [&, i] {
+                std::lock_guard lock(mutex);
+                second.push_back(i);
+            });
+        }
+        pool.Join();
+
+        const WorkerPool::Stats stats = pool.GetStats();
+        EXPECT_EQ(stats.threads, 4u);
+        EXPECT_EQ(stats.submitted, 200u);
+        EXPECT_EQ(stats.completed, 200u);
+        EXPECT_EQ(stats.queued, 0u);
+        EXPECT_EQ(stats.active_keys, 0u);
+        EXPECT_GE(stats.max_queued, 1u);
+    }
+
+    std::vector<int> expected(100);
+    for (int i = 0; i < 100; ++i) {
+        expected[i] = i;
+    }
+    EXPECT_EQ(first, expected);
+    EXPECT_EQ(second, expected);
+}
+
+TEST(WorkerPoolTest, SlowKeyDoesNotBlockOthers) {
+    WorkerPool pool(2);
+    std::promise<void> other_done;
+    std::future<void> other_future = other_done.get_future();
+    std::atomic<bool> released{false};
+
+    // Первый чат ждет, пока выполнится задача второго
+    pool.Submit(1, [&] { released = other_future.wait_for(std::chrono::seconds(5)) ==
+                                    std::future_status::ready; });
+    pool.Submit(2, [&] { other_done.set_value(); });
+    pool.Join();
+
+    EXPECT_TRUE(released);
+}
+
+// Тесты для TokenBucket
+TEST(TokenBucketTest, AllowsBurstThenLimitsRate) {
+    const TokenBucket::Clock::time_point start{};
+    TokenBucket bucket(2.0, 3.0, start);
+
+    EXPECT_EQ(bucket.Reserve(start), 0ms);
+    EXPECT_EQ(bucket.Reserve(start), 0ms);
+    EXPECT_EQ(bucket.Reserve(start), 0ms);
+    EXPECT_EQ(bucket.Reserve(start), 500ms);
+    // Токен взят в долг: следующий появится еще через полсекунды
+    EXPECT_EQ(bucket.Reserve(start), 1000ms);
+}
+
+TEST(TokenBucketTest, RefillsUpToBurst) {
+    const TokenBucket::Clock::time_point start{};
+    TokenBucket bucket(1.0, 2.0, start);
+    bucket.Reserve(start);
+    bucket.Reserve(start);
+    EXPECT_FALSE(bucket.IsFull(start));
+
+    EXPECT_EQ(bucket.Reserve(start + 1s), 0ms);
+    EXPECT_TRUE(bucket.IsFull(start + 1h));
+    EXPECT_EQ(bucket.Reserve(start + 1h), 0ms);
+    EXPECT_EQ(bucket.Reserve(start + 1h), 0ms);
+    EXPECT_EQ(bucket.Reserve(start + 1h), 1000ms);
+}
+
+TEST(TokenBucketTest, PausesAfterRetryAfter) {
+    const TokenBucket::Clock::time_point start{};
+    TokenBucket bucket(2.0, 3.0, start);
+    EXPECT_EQ(bucket.Reserve(start), 0ms);
+
+    bucket.Pause(2s, start);
+    EXPECT_FALSE(bucket.IsFull(start + 1s));
+    EXPECT_EQ(bucket.Reserve(start + 1s), 1000ms);
+    // Накопленные токены не уходят пачкой после паузы
+    EXPECT_EQ(bucket.Reserve(start + 1s), 1500ms);
+    EXPECT_EQ(bucket.Reserve(start + 10s), 0ms);
+}
+
+TEST(TokenBucketTest, RejectsZeroRate) {
+    EXPECT_THROW(TokenBucket(0.0, 1.0), std::invalid_argument);
+    EXPECT_THROW(TokenBucket(-1.0, 1.0), std::invalid_argument);
+}
+
+// Тесты для ListCache
+TEST(ListCacheTest, MatchesPlainOutput) {
+    task::TaskManager tasks = task::TaskManager::FromJson(
+        json::parse(R"([{"text":"milk","done":false},{"text":"bread","done":true}])"), "unused");
+    ListCache cache;
+
+    EXPECT_EQ(cache.GetLines(tasks, 0, 10), "0. [ ] milk\n1. [x] bread\n");
+    EXPECT_EQ(cache.GetLines(tasks, 1, 10), "1. [x] bread\n");
+    EXPECT_EQ(cache.GetLines(tasks, 5, 10), "");
+
+    task::OutputBuffer out(task::OutputBuffer::NO_FD);
+    tasks.AddTask("eggs");
+    tasks.PrintTasks(out);
+    EXPECT_EQ(cache.GetLines(tasks, 0, 10), out.GetData());
+}
+
+TEST(ListCacheTest, RendersOnlyChangedLines) {
+    task::TaskManager tasks = task::TaskManager::FromJson(json::array(), "unused");
+    for (int i = 0; i < 100; ++i) {
+        tasks.AddTask("task " + std::to_string(i));
+    }
+    ListCache cache;
+    cache.GetLines(tasks, 0, 50);
+    EXPECT_EQ(cache.GetRenderedCount(), 100u);
+
+    // Без изменений страница берется из кэша
+    cache.GetLines(tasks, 50, 50);
+    EXPECT_EQ(cache.GetRenderedCount(), 100u);
+
+    const std::vector<size_t> toggled = {10, 70};
+    tasks.ToggleTasks(toggled);
+    EXPECT_EQ(cache.GetLines(tasks, 70, 1), "70. [x] task 70\n");
+    EXPECT_EQ(cache.GetRenderedCount(), 102u);
+
+    tasks.AddTask("new");
+    EXPECT_EQ(cache.GetLines(tasks, 100, 1), "100. [ ] new\n");
+    EXPECT_EQ(cache.GetRenderedCount(), 103u);
+
+    // Удаление сдвигает номера всех задач после удаленной
+    tasks.RemoveTask(95);
+    EXPECT_EQ(cache.GetLines(tasks, 94, 10), "94. [ ] task 94\n95. [ ] task 96\n"
+                                             "96. [ ] task 97\n97. [ ] task 98\n"
+                                             "98. [ ] task 99\n99. [ ] new\n");
+    EXPECT_EQ(cache.GetRenderedCount(), 108u);
+    EXPECT_EQ(cache.GetLines(tasks, 10, 1), "10. [x] task 10\n");
+
+    tasks.ClearTasks();
+    EXPECT_EQ(cache.GetLines(tasks, 0, 50), "");
+}
+
+TEST(ListCacheTest, RendersRemovalFromLoadedList) {
+    // Задачи из файла получают разные версии, иначе сдвиг после удаления не виден
+    task::TaskManager tasks = task::TaskManager::FromJson(
+        json::parse(R"([{"text":"milk","done":false},{"text":"bread","done":true}])"), "unused");
+    ListCache cache;
+    EXPECT_EQ(cache.GetLines(tasks, 0, 10), "0. [ ] milk\n1. [x] bread\n");
+
+    tasks.RemoveTask(0);
+    EXPECT_EQ(cache.GetLines(tasks, 0, 10), "0. [x] bread\n");
+}
+
+// Тесты для склейки ответов
+TEST(CoalesceTest, JoinsRepliesThatFit) {
+    std::deque<OutgoingMessage> queue{{1, "first"}, {1, "second"}, {1, "third"}};
+
+    EXPECT_EQ(TakeCoalescedMessage(queue, 15).text, "first\n\nsecond");
+    EXPECT_EQ(queue.size(), 1);
+    EXPECT_EQ(TakeCoalescedMessage(queue, 15).text, "third");
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(CoalesceTest, SplitsLongReply) {
+    std::deque<OutgoingMessage> queue{{1, "aaaa\nbbbb\ncccc"}, {1, "tail"}};
+
+    EXPECT_EQ(TakeCoalescedMessage(queue, 10).text, "aaaa\nbbbb\n");
+    EXPECT_EQ(TakeCoalescedMessage(queue, 10).text, "cccc\n\ntail");
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(CoalesceTest, SendsKeyboardsAndEditsAlone) {
+    const json keyboard = {{"inline_keyboard", json::array()}};
+    std::deque<OutgoingMessage> queue{{1, "done"}, {1, "list", keyboard}, {1, "tail"},
+                                      {1, "aaaa\nbbbb", keyboard}, {1, "edited", nullptr, 5}};
+
+    EXPECT_EQ(TakeCoalescedMessage(queue, 100).text, "done");
+    const OutgoingMessage list = TakeCoalescedMessage(queue, 100);
+    EXPECT_EQ(list.text, "list");
+    EXPECT_EQ(list.reply_markup, keyboard);
+    EXPECT_EQ(TakeCoalescedMessage(queue, 100).text, "tail");
+
+    // Клавиатура остается у последней части длинного сообщения
+    const OutgoingMessage first = TakeCoalescedMessage(queue, 6);
+    EXPECT_EQ(first.text, "aaaa\n");
+    EXPECT_TRUE(first.reply_markup.is_null());
+    EXPECT_EQ(TakeCoalescedMessage(queue, 6).reply_markup, keyboard);
+
+    const OutgoingMessage edit = TakeCoalescedMessage(queue, 100);
+    EXPECT_EQ(edit.edit_message_id, 5);
+    EXPECT_FALSE(edit.IsPlain());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(CoalesceTest, CountsUtf16Units) {
+    EXPECT_EQ(Utf16Length("abc"), 3);
+    EXPECT_EQ(Utf16Length("задача"), 6);
+    EXPECT_EQ(Utf16Length("\xF0\x9F\x98\x80"), 2);
+}
+
+// Фикстура для тестов ChatStore
+class ChatStoreTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / "chat_store_test";
+        std::filesystem::remove_all(dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path dir_;
+};
+
+TEST_F(ChatStoreTest, KeepsSeparateListPerChat) {
+    ChatStore store(dir_, 4);
+    {
+        ChatStore::Handle tasks = store.Acquire(1);
+        tasks->AddTask("first chat");
+        tasks->Save();
+    }
+    {
+        ChatStore::Handle tasks = store.Acquire(2);
+        EXPECT_TRUE(tasks->GetTasks().empty());
+    }
+
+    EXPECT_EQ(store.GetLoadedCount(), 2);
+    EXPECT_TRUE(std::filesystem::exists(store.GetListPath(1)));
+    EXPECT_FALSE(std::filesystem::exists(store.GetListPath(2)));
+}
+
+TEST_F(ChatStoreTest, EvictsIdleListsAndReloads) {
+    const ChatStore::Clock::time_point start = ChatStore::Clock::now();
+    ChatStore store(dir_, 4, 10min);
+    {
+        ChatStore::Handle tasks = store.Acquire(1, start);
+        tasks->AddTask("saved");
+        tasks->Save();
+    }
+
+    EXPECT_EQ(store.EvictIdle(start + 5min), 0);
+    EXPECT_EQ(store.EvictIdle(start + 11min), 1);
+    EXPECT_EQ(store.GetLoadedCount(), 0);
+
+    ChatStore::Handle tasks = store.Acquire(1);
+    ASSERT_EQ(tasks->GetTasks().size(), 1);
+    EXPECT_EQ(tasks->GetTasks()[0].text, "saved");
+}
+
+TEST_F(ChatStoreTest, DoesNotEvictListInUse) {
+    const ChatStore::Clock::time_point start = ChatStore::Clock::now();
+    ChatStore store(dir_, 1, 1min);
+    ChatStore::Handle tasks = store.Acquire(1, start);
+    tasks->AddTask("not saved yet");
+
+    EXPECT_EQ(store.EvictIdle(start + 1h), 0);
+    EXPECT_EQ(store.GetLoadedCount(), 1);
+}
+
+TEST_F(ChatStoreTest, CommitsUpdateIdWithTasks) {
+    const ChatStore::Clock::time_point start = ChatStore::Clock::now();
+    ChatStore store(dir_, 4, 1min);
+    {
+        ChatStore::Handle tasks = store.Acquire(1, start);
+        EXPECT_EQ(tasks.GetUpdateId(), 0);
+        tasks->AddTask("from update 15");
+        tasks.Commit(15);
+        // Более старое обновление не откатывает update_id
+        tasks.Commit(10);
+        EXPECT_EQ(tasks.GetUpdateId(), 15);
+    }
+    // Несохраненный список не выгружается
+    EXPECT_EQ(store.EvictIdle(start + 1h), 0);
+    store.Flush();
+    ASSERT_EQ(store.EvictIdle(start + 1h), 1);
+
+    ChatStore::Handle tasks = store.Acquire(1);
+    EXPECT_EQ(tasks.GetUpdateId(), 15);
+    ASSERT_EQ(tasks->GetTasks().size(), 1);
+    EXPECT_EQ(tasks->GetTasks()[0].text, "from update 15");
+}
+
+TEST_F(ChatStoreTest, SavesOffset) {
+    ChatStore store(dir_);
+    EXPECT_EQ(store.LoadOffset(), 0);
+
+    store.SetOffset(42);
+    store.Flush();
+    EXPECT_EQ(ChatStore(dir_).LoadOffset(), 42);
+}
+
+TEST_F(ChatStoreTest, WritesOtherListsWhenOneFails) {
+    ChatStore store(dir_);
+    {
+        ChatStore::Handle tasks = store.Acquire(1);
+        tasks->AddTask("saved");
+        tasks.Commit(5);
+    }
+    store.SetOffset(6);
+    store.Flush();
+
+    // Непустой каталог на месте файла не дает заменить список первого чата
+    std::filesystem::remove(store.GetListPath(1));
+    std::filesystem::create_directories(store.GetListPath(1) / "blocked");
+    {
+        ChatStore::Handle tasks = store.Acquire(1);
+        tasks->AddTask("not saved");
+        tasks.Commit(9);
+    }
+    {
+        ChatStore::Handle tasks = store.Acquire(2);
+        tasks->AddTask("second chat");
+        tasks.Commit(10);
+    }
+    store.SetOffset(11);
+    EXPECT_THROW(store.Flush(), std::runtime_error);
+
+    // Второй чат записан, а смещение не ушло дальше незаписанного обновления 9
+    EXPECT_EQ(ChatStore(dir_).Acquire(2).GetUpdateId(), 10);
+    EXPECT_EQ(store.LoadOffset(), 6);
+
+    std::filesystem::remove_all(store.GetListPath(1));
+    store.Flush();
+    EXPECT_EQ(store.LoadOffset(), 11);
+    EXPECT_EQ(ChatStore(dir_).Acquire(1).GetUpdateId(), 9);
+}
+
+// Тесты для CommandHandler
+class CommandHandlerTest : public ChatStoreTest {
+ protected:
+    std::vector<std::string> Run(CommandHandler& handler, const std::string& text,
+                                 long update_id = 0) {
+        Message message(1, 100, text);
+        message.SetUpdateId(update_id);
+        std::vector<std::string> replies;
+        handler.HandleCommand(message, [&replies](const std::string& reply, long chat_id) {
+            EXPECT_EQ(chat_id, 100);
+            replies.push_back(reply);
+        });
+        return replies;
+    }
+};
+
+TEST_F(CommandHandlerTest, DispatchesBuiltinCommands) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+
+    EXPECT_EQ(Run(handler, "/add milk"), std::vector<std::string>{"Задача добавлена успешно!"});
+    EXPECT_EQ(Run(handler, "/LIST"), std::vector<std::string>{"Список задач:\n0. [ ] milk\n"});
+    EXPECT_EQ(Run(handler, "/edit 0 bread").at(0).find("Неизвестная команда"), 0u);
+}
+
+TEST_F(CommandHandlerTest, AcceptsCommaAndSpaceBetweenIndices) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+    for (const char* text : {"/add a", "/add b", "/add c", "/add d"}) {
+        Run(handler, text);
+    }
+
+    EXPECT_EQ(Run(handler, "/done 1, 2"), std::vector<std::string>{"Обновлен статус задач: 2."});
+    EXPECT_EQ(Run(handler, "/remove 0 ,3"), std::vector<std::string>{"Удалено задач: 2."});
+    EXPECT_EQ(Run(handler, "/LIST"), std::vector<std::string>{"Список задач:\n0. [x] b\n1. [x] c\n"});
+}
+
+TEST_F(CommandHandlerTest, SkipsAppliedUpdates) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+
+    EXPECT_EQ(Run(handler, "/add milk", 5).size(), 1u);
+    EXPECT_TRUE(Run(handler, "/add milk", 5).empty());
+    EXPECT_EQ(store.Acquire(100)->CountTasks(), 1u);
+}
+
+TEST_F(CommandHandlerTest, RunsPluginCommands) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+    handler.RegisterCommand("Count", "Число задач",
+                            [](const Message& message, ChatStore::Handle& list,
+                               CommandHandler::Reply reply) {
+                                reply(std::to_string(list->CountTasks()), message.GetChatId());
+                            });
+
+    Run(handler, "/add milk");
+    EXPECT_EQ(Run(handler, "/count"), std::vector<std::string>{"1"});
+    EXPECT_NE(Run(handler, "/help").at(0).find("/count - Число задач"), std::string::npos);
+
+    EXPECT_THROW(handler.RegisterCommand("list", "", {}), std::invalid_argument);
+    EXPECT_THROW(handler.RegisterCommand("COUNT", "", {}), std::invalid_argument);
+}
+
+TEST_F(CommandHandlerTest, ListHasTaskButtons) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+    for (size_t i = 0; i <= CommandHandler::LIST_PAGE_SIZE; ++i) {
+        Run(handler, "/add task " + std::to_string(i));
+    }
+
+    std::vector<OutgoingMessage> replies;
+    handler.HandleCommand(Message(1, 100, "/list"),
+                          [&replies](OutgoingMessage reply) { replies.push_back(reply); });
+    ASSERT_EQ(replies.size(), 1u);
+    const json& keyboard = replies[0].reply_markup.at("inline_keyboard");
+    // Десять рядов по пять задач и переход на вторую страницу
+    ASSERT_EQ(keyboard.size(), 11u);
+    EXPECT_EQ(keyboard[0].size(), CommandHandler::KEYBOARD_ROW_SIZE);
+    const uint64_t revision = store.Acquire(100)->GetTasks()[1].revision;
+    EXPECT_EQ(keyboard[0][1], json({{"text", "[ ] 1"},
+                                    {"callback_data", std::format("done:1:1:{}", revision)}}));
+    EXPECT_EQ(keyboard[10], json::parse(R"([{"text":"2 »","callback_data":"list:2"}])"));
+}
+
+TEST_F(CommandHandlerTest, CallbackTogglesTaskAndEditsList) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+    Run(handler, "/add milk");
+
+    std::vector<OutgoingMessage> replies;
+    auto press = [&](const std::string& data, long update_id) {
+        const CallbackQuery query{"id", 100, 7, update_id, data};
+        return handler.HandleCallback(
+            query, [&replies](OutgoingMessage reply) { replies.push_back(reply); });
+    };
+
+    const std::string milk = std::format("done:1:0:{}", store.Acquire(100)->GetTasks()[0].revision);
+    EXPECT_EQ(press(milk, 10), "");
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].edit_message_id, 7);
+    EXPECT_EQ(replies[0].text, "Список задач:\n0. [x] milk\n");
+    EXPECT_EQ(replies[0].reply_markup["inline_keyboard"][0][0]["text"], "[x] 0");
+    EXPECT_TRUE(store.Acquire(100)->GetTasks()[0].done);
+
+    // Повтор того же обновления после перезапуска не переключает задачу снова
+    EXPECT_EQ(press(milk, 10), "");
+    EXPECT_EQ(replies.size(), 1u);
+    EXPECT_TRUE(store.Acquire(100)->GetTasks()[0].done);
+
+    // Задачи с таким номером нет: сообщение просто обновляется
+    EXPECT_EQ(press("done:1:3:1", 11), "Список изменился, сообщение обновлено.");
+    ASSERT_EQ(replies.size(), 2u);
+    EXPECT_EQ(replies[1].edit_message_id, 7);
+
+    EXPECT_EQ(press("bogus", 12), "Кнопка устарела.");
+    EXPECT_EQ(press("done:1:0", 13), "Кнопка устарела.");
+    EXPECT_EQ(replies.size(), 2u);
+}
+
+TEST_F(CommandHandlerTest, OldButtonDoesNotToggleShiftedTask) {
+    ChatStore store(dir_);
+    CommandHandler handler(store);
+    Run(handler, "/add milk");
+    Run(handler, "/add bread");
+
+    std::vector<OutgoingMessage> replies;
+    handler.HandleCommand(Message(1, 100, "/list"),
+                          [&replies](OutgoingMessage reply) { replies.push_back(reply); });
+    ASSERT_EQ(replies.size(), 1u);
+    const std::string bread =
+        replies[0].reply_markup["inline_keyboard"][0][1]["callback_data"].get<std::string>();
+    const std::string milk =
+        replies[0].reply_markup["inline_keyboard"][0][0]["callback_data"].get<std::string>();
+
+    // После удаления bread стоит под номером 0, а старая кнопка 0 относится к milk
+    Run(handler, "/remove 0");
+    replies.clear();
+    const CallbackQuery query{"id", 100, 7, 20, milk};
+    EXPECT_EQ(handler.HandleCallback(
+                  query, [&replies](OutgoingMessage reply) { replies.push_back(reply); }),
+              "Список изменился, сообщение обновлено.");
+    ASSERT_EQ(replies.size(), 1u);
+    EXPECT_EQ(replies[0].edit_message_id, 7);
+    EXPECT_EQ(replies[0].text, "Список задач:\n0. [ ] bread\n");
+    EXPECT_FALSE(store.Acquire(100)->GetTasks()[0].done);
+
+    // Кнопка самой bread из старого сообщения указывает на номер, которого уже нет
+    const CallbackQuery second{"id", 100, 7, 21, bread};
+    EXPECT_EQ(handler.HandleCallback(second, [](OutgoingMessage) {}),
+              "Список изменился, сообщение обновлено.");
+    EXPECT_FALSE(store.Acquire(100)->GetTasks()[0].done);
+}
+
+TEST_F(ChatStoreTest, ChatsInOneShardDoNotBlockEachOther) {
+    // Один шард: чаты делят таблицу, но не блокировку списка
+    ChatStore store(dir_, 1);
+    ChatStore::Handle first = store.Acquire(1);
+
+    auto second = std::async(std::launch::async, [&store] {
+        ChatStore::Handle tasks = store.Acquire(2);
+        return tasks->GetTasks().size();
+    });
+    EXPECT_EQ(second.wait_for(5s), std::future_status::ready);
+}
+
+// Тесты для WriteBehind
+TEST(WriteBehindTest, CoalescesBurstIntoOneWrite) {
+    std::atomic<int> writes = 0;
+    WriteBehindOptions options;
+    options.debounce = 50ms;
+    options.max_delay = 5s;
+    WriteBehind writer([&writes] { ++writes; }, options);
+
+    for (int i = 0; i < 20; ++i) {
+        writer.Notify();
+    }
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(writes, 1);
+}
+
+TEST(WriteBehindTest, WritesAfterMaxPendingWithoutWaiting) {
+    std::promise<void> written;
+    WriteBehindOptions options;
+    options.debounce = 1h;
+    options.max_delay = 1h;
+    options.max_pending = 3;
+    WriteBehind writer([&written, first = true]() mutable {
+        if (std::exchange(first, false)) {
+            written.set_value();
+        }
+    }, options);
+
+    writer.Notify();
+    writer.Notify();
+    writer.Notify();
+    EXPECT_EQ(written.get_future().wait_for(5s), std::future_status::ready);
+}
+
+TEST(WriteBehindTest, WritesPendingChangesOnStop) {
+    int writes = 0;
+    {
+        WriteBehindOptions options;
+        options.debounce = 1h;
+        options.max_delay = 1h;
+        WriteBehind writer([&writes] { ++writes; }, options);
+        writer.Notify();
+    }
+    EXPECT_EQ(writes, 1);
+}
+
+// Тесты для метрик
+TEST(MetricsTest, CounterSumsAllThreads) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&counter] {
+            for (int j = 0; j < 10000; ++j) {
+                counter.Add();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter.Get(), 80000u);
+}
+
+TEST(MetricsTest, RendersPrometheusText) {
+    Histogram histogram;
+    histogram.Observe(1ms);
+    histogram.Observe(3ms);
+    histogram.Observe(2s);
+    Counter added;
+    added.Add(5);
+    Counter listed;
+    Gauge queue;
+    queue.Set(-2);
+
+    MetricsRegistry registry;
+    registry.Add("test_seconds", "Test time", histogram);
+    registry.Add("test_commands_total", "Commands", added, R"(command="add")");
+    registry.Add("test_commands_total", "Commands", listed, R"(command="list")");
+    registry.Add("test_queue", "Queue size", queue);
+    const std::string text = registry.Render();
+
+    // Границы включительные, корзины накопительные
+    EXPECT_NE(text.find("# TYPE test_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_bucket{le=\"0.0005\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_bucket{le=\"0.001\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_bucket{le=\"0.005\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_bucket{le=\"2.5\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_sum 2.004\n"), std::string::npos);
+    EXPECT_NE(text.find("test_seconds_count 3\n"), std::string::npos);
+
+    EXPECT_NE(text.find("test_commands_total{command=\"add\"} 5\n"), std::string::npos);
+    EXPECT_NE(text.find("test_commands_total{command=\"list\"} 0\n"), std::string::npos);
+    EXPECT_EQ(text.find("# HELP test_commands_total"), text.rfind("# HELP test_commands_total"));
+    EXPECT_NE(text.find("# TYPE test_queue gauge\ntest_queue -2\n"), std::string::npos);
+}
+
+TEST(MetricsTest, ServerAnswersOnlyMetricsPath) {
+    net::io_context ioc;
+    MetricsServer server(ioc.get_executor(), MetricsOptions{}, [] { return "up 1\n"; });
+
+    http::request<http::string_body> request{http::verb::get, "/metrics", 11};
+    auto response = server.HandleRequest(request);
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response.body(), "up 1\n");
+
+    request.target("/other");
+    EXPECT_EQ(server.HandleRequest(request).result(), http::status::not_found);
+    request.target("/metrics");
+    request.method(http::verb::post);
+    EXPECT_EQ(server.HandleRequest(request).result(), http::status::method_not_allowed);
+}
+
+}  // namespace bot
@@ -0,0 +1,323 @@
+#include "Batch.hpp"
+#include "Daemon.hpp"
+#include "Shell.hpp"
+#include "Task.hpp"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace cli {
+
+// Фикстура для тестов модуля cli
+class CliTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        test_dir_ = fs::temp_directory_path() / "cli_test";
+        fs::create_directories(test_dir_);
+
+        config_file_ = test_dir_ / "config_todo.json";
+        task_file_ = test_dir_ / "test_list.json";
+
+        json config;
+        config["path"] = test_dir_.string();
+        config["name"] = "test_list.json";
+
+        std::ofstream file(config_file_);
+        file << config.dump(4);
+        file.close();
+    }
+
+    void TearDown() override {
+        if (fs::exists(test_dir_)) {
+            fs::remove_all(test_dir_);
+        }
+    }
+
+    json ReadTaskFile() const {
+        std::ifstream file(task_file_);
+        return json::parse(file);
+    }
+
+    fs::path test_dir_;
+    fs::path config_file_;
+    fs::path task_file_;
+};
+
+TEST_F(CliTest, RunBatch_SavesOnceAtEnd) {
+    task::TaskManager manager(config_file_.string());
+    task::OutputBuffer out(task::OutputBuffer::NO_FD);
+    std::ostringstream err;
+
+    const std::string script =
+        "# comment\n"
+        "add Buy milk\n"
+        "\n"
+        "add \"Call mom\"\n"
+        "done 1\n"
+        "list completed\n";
+
+    const BatchStats stats = RunBatch(manager, script, 0, out, err);
+
+    EXPECT_EQ(stats.executed, 4);
+    EXPECT_EQ(stats.failed, 0);
+    EXPECT_EQ(stats.saves, 1);
+    EXPECT_TRUE(err.str().empty());
+    EXPECT_NE(out.GetData().find("1. [x] Call mom\n"), std::string::npos);
+
+    const json j = ReadTaskFile();
+    ASSERT_EQ(j.size(), 2);
+    EXPECT_EQ(j[0]["text"], "Buy milk");
+    EXPECT_EQ(j[1]["done"], true);
+}
+
+TEST_F(CliTest, RunBatch_ReportsFailedLines) {
+    task::TaskManager manager(config_file_.string());
+    task::OutputBuffer out(task::OutputBuffer::NO_FD);
+    std::ostringstream err;
+
+    const std::string script =
+        "add First\r\n"
+        "done 7\r\n"
+        "unknown\r\n"
+        "batch -\r\n"
+        "add Second\r\n";
+
+    const BatchStats stats = RunBatch(manager, script, 1, out, err);
+
+    EXPECT_EQ(stats.executed, 2);
+    EXPECT_EQ(stats.failed, 3);
+    EXPECT_EQ(stats.saves, 2);
+    EXPECT_NE(err.str().find("line 2: "), std::string::npos);
+    EXPECT_NE(err.str().find("line 3: "), std::string::npos);
+    EXPECT_NE(err.str().find("line 4: "), std::string::npos);
+    EXPECT_EQ(manager.GetTasks().size(), 2);
+}
+
+TEST_F(CliTest, RunBatch_ConfigSwitchesList) {
+    task::TaskManager manager(config_file_.string());
+    task::OutputBuffer out(task::OutputBuffer::NO_FD);
+    std::ostringstream err;
+
+    const std::string script =
+        "add First\n"
+        "config name other_list.json\n"
+        "add Second\n";
+
+    const BatchStats stats = RunBatch(manager, script, 0, out, err);
+
+    EXPECT_EQ(stats.failed, 0);
+    EXPECT_EQ(stats.saves, 2);
+    EXPECT_EQ(manager.GetFullName(), (test_dir_ / "other_list.json").string());
+
+    const json j = ReadTaskFile();
+    ASSERT_EQ(j.size(), 1);
+    EXPECT_EQ(j[0]["text"], "First");
+
+    std::ifstream other(test_dir_ / "other_list.json");
+    const json other_j = json::parse(other);
+    ASSERT_EQ(other_j.size(), 1);
+    EXPECT_EQ(other_j[0]["text"], "Second");
+}
+
+// Тесты для интерактивного режима
+TEST_F(CliTest, Shell_ExecutesAndSavesOnExit) {
+    task::TaskManager manager(config_file_.string());
+    task::OutputBuffer out(task::OutputBuffer::NO_FD);
+
+    {
+        Shell shell(manager);
+        EXPECT_TRUE(shell.ExecuteLine("add First", out));
+        EXPECT_TRUE(shell.ExecuteLine("  ", out));
+        EXPECT_TRUE(shell.IsDirty());
+        EXPECT_FALSE(fs::exists(task_file_));
+        EXPECT_THROW(shell.ExecuteLine("daemon", out), std::invalid_argument);
+        EXPECT_FALSE(shell.ExecuteLine("exit", out));
+    }
+
+    const json j = ReadTaskFile();
+    ASSERT_EQ(j.size(), 1);
+    EXPECT_EQ(j[0]["text"], "First");
+}
+
+TEST_F(CliTest, Shell_ConfigSavesAndSwitchesList) {
+    task::TaskManager manager(config_file_.string());
+    task::OutputBuffer out(task::OutputBuffer::NO_FD);
+
+    Shell shell(manager);
+    EXPECT_TRUE(shell.ExecuteLine("add First", out));
+    EXPECT_TRUE(shell.ExecuteLine("config name other_list.json", out));
+    EXPECT_FALSE(shell.IsDirty());
+    EXPECT_EQ(manager.GetFullName(), (test_dir_ / "other_list.json").string());
+    EXPECT_TRUE(manager.GetTasks().empty());
+
+    const json j = ReadTaskFile();
+    ASSERT_EQ(j.size(), 1);
+    EXPECT_EQ(j[0]["text"], "First");
+}
+
+TEST_F(CliTest, Shell_KeepsRunningWhenSaveFails) {
+    // Вместо каталога списка лежит файл: запись не удастся, пока его не заменят каталогом
+    const fs::path blocked = test_dir_ / "blocked";
+    std::ofstream(blocked) << "not a directory";
+    task::TaskManager manager = task::TaskManager::FromFile((blocked / "list.json").string());
+
+    int input[2];
+    ASSERT_EQ(::pipe(input), 0);
+    const int saved_stdin = ::dup(STDIN_FILENO);
+    ::dup2(input[0], STDIN_FILENO);
+    ::close(input[0]);
+
+    std::thread user([&] {
+        const std::string line = "add First\n";
+        EXPECT_EQ(::write(input[1], line.data(), line.size()),
+                  static_cast<ssize_t>(line.size()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        fs::remove(blocked);
+        fs::create_directories(blocked);
+        // Повтор после паузы сохраняет список, пока сеанс еще открыт
+        std::this_thread::sleep_for(Shell::SAVE_RETRY_DELAY + std::chrono::milliseconds(500));
+        EXPECT_TRUE(fs::exists(blocked / "list.json"));
+        ::close(input[1]);
+    });
+
+    {
+        Shell shell(manager, std::chrono::milliseconds(0));
+        EXPECT_NO_THROW(shell.Run());
+        EXPECT_FALSE(shell.IsDirty());
+    }
+    user.join();
+    ::dup2(saved_stdin, STDIN_FILENO);
+    ::close(saved_stdin);
+}
+
+TEST_F(CliTest, Shell_Complete) {
+    task::TaskManager manager(config_file_.string());
+    for (size_t i = 0; i < 12; ++i) {
+        manager.AddTask("Task " + std::to_string(i));
+    }
+
+    Shell shell(manager);
+    EXPECT_EQ(shell.Complete("ed"), std::vector<std::string>{"edit"});
+    EXPECT_EQ(shell.Complete("done 1"), (std::vector<std::string>{"1", "10", "11"}));
+    EXPECT_EQ(shell.Complete("remove "), (std::vector<std::string>{"0", "1", "2", "3", "4", "5",
+                                                                   "6", "7", "8", "9", "10", "11"}));
+    EXPECT_EQ(shell.Complete("list --format=n"), std::vector<std::string>{"--format=ndjson"});
+    EXPECT_TRUE(shell.Complete("done 5 ").empty());
+    EXPECT_TRUE(shell.Complete("unknown ").empty());
+}
+
+// Тесты для демона
+class DaemonTest : public CliTest {
+ protected:
+    void StartDaemon(std::chrono::milliseconds client_timeout) {
+        socket_path_ = (test_dir_ / "todo.sock").string();
+        daemon_.emplace(config_file_.string(), socket_path_, client_timeout);
+        thread_ = std::thread([this] { daemon_->Run(); });
+        for (int i = 0; i < 500 && !IsDaemonRunning(socket_path_); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_TRUE(IsDaemonRunning(socket_path_));
+    }
+
+    void TearDown() override {
+        if (thread_.joinable()) {
+            daemon_->Stop();
+            thread_.join();
+        }
+        daemon_.reset();
+        CliTest::TearDown();
+    }
+
+    std::string socket_path_;
+    std::optional<Daemon> daemon_;
+    std::thread thread_;
+};
+
+TEST_F(DaemonTest, ForwardsCommands) {
+    StartDaemon(Daemon::DEFAULT_CLIENT_TIMEOUT);
+
+    const std::vector<std::string_view> add = {"add", "From client"};
+    EXPECT_EQ(ForwardToDaemon(socket_path_, add), 0);
+    const std::vector<std::string_view> done = {"done", "7"};
+    EXPECT_EQ(ForwardToDaemon(socket_path_, done), 1);
+
+    const json j = ReadTaskFile();
+    ASSERT_EQ(j.size(), 1);
+    EXPECT_EQ(j[0]["text"], "From client");
+}
+
+TEST_F(DaemonTest, DropsSilentClient) {
+    StartDaemon(std::chrono::milliseconds(200));
+
+    // Подключается и молчит: остальные клиенты ждут не дольше таймаута
+    const int silent = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(silent, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+    ASSERT_EQ(::connect(silent, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::string_view> add = {"add", "After silent"};
+    EXPECT_EQ(ForwardToDaemon(socket_path_, add), 0);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+    ::close(silent);
+
+    EXPECT_EQ(ReadTaskFile().size(), 1);
+}
+
+TEST_F(CliTest, ForwardToDaemon_TimesOutOnStuckDaemon) {
+    // Сокет слушает, но никто не принимает подключения и не отвечает
+    const std::string socket_path = (test_dir_ / "todo.sock").string();
+    const int stuck = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(stuck, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    ASSERT_EQ(::bind(stuck, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::listen(stuck, 1), 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::string_view> args = {"list"};
+    EXPECT_THROW(ForwardToDaemon(socket_path, args, {}, std::chrono::milliseconds(200)),
+                 std::runtime_error);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+    ::close(stuck);
+}
+
+TEST_F(CliTest, ForwardToDaemon_FallsBackWithoutDaemon) {
+    const std::string socket_path = (test_dir_ / "todo.sock").string();
+    const std::vector<std::string_view> args = {"list"};
+    EXPECT_FALSE(IsDaemonRunning(socket_path));
+    EXPECT_EQ(ForwardToDaemon(socket_path, args), std::nullopt);
+
+    // Файл сокета, оставшийся после сбоя демона
+    std::ofstream(socket_path).close();
+    EXPECT_FALSE(IsDaemonRunning(socket_path));
+    EXPECT_EQ(ForwardToDaemon(socket_path, args), std::nullopt);
+}
+
+}  // namespace cli
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
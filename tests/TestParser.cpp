@@ -2,8 +2,28 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 using namespace parser;
 
+// Счетчик выделений памяти для проверки повторного разбора без аллокаций
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
 // Тесты для CommandToEnum
 TEST(CommandToEnumTest, ValidCommands) {
     EXPECT_EQ(CommandToEnum("add"), TypeCommand::ADD);
@@ -14,6 +34,8 @@ TEST(CommandToEnumTest, ValidCommands) {
     EXPECT_EQ(CommandToEnum("edit"), TypeCommand::EDIT);
     EXPECT_EQ(CommandToEnum("help"), TypeCommand::HELP);
     EXPECT_EQ(CommandToEnum("config"), TypeCommand::CONFIG);
+    EXPECT_EQ(CommandToEnum("batch"), TypeCommand::BATCH);
+    EXPECT_EQ(CommandToEnum("daemon"), TypeCommand::DAEMON);
 }
 
 TEST(CommandToEnumTest, InvalidCommand) {
@@ -21,6 +43,25 @@ TEST(CommandToEnumTest, InvalidCommand) {
     EXPECT_THROW(CommandToEnum(""), std::invalid_argument);
 }
 
+TEST(CommandToEnumTest, BotOnlyCommand) {
+    EXPECT_THROW(CommandToEnum("start"), std::invalid_argument);
+}
+
+// Тесты для FindCommand
+TEST(FindCommandTest, LookupByScope) {
+    for (const CommandInfo& command : COMMANDS) {
+        const CommandInfo* found = FindCommand(command.name);
+        ASSERT_NE(found, nullptr);
+        EXPECT_EQ(found->type, command.type);
+    }
+
+    EXPECT_EQ(FindCommand("Remove", BOT)->type, TypeCommand::REMOVE);
+    EXPECT_EQ(FindCommand("start", BOT)->type, TypeCommand::START);
+    EXPECT_EQ(FindCommand("edit", BOT), nullptr);
+    EXPECT_EQ(FindCommand("lis"), nullptr);
+    EXPECT_EQ(FindCommand(""), nullptr);
+}
+
 // Тесты для IsValidCommandWords
 TEST(IsValidCommandWordsTest, AddCommand) {
     EXPECT_FALSE(IsValidCommandWords(TypeCommand::ADD, 2));  // add
@@ -43,13 +84,13 @@ TEST(IsValidCommandWordsTest, ClearCommand) {
 TEST(IsValidCommandWordsTest, DoneCommand) {
     EXPECT_TRUE(IsValidCommandWords(TypeCommand::DONE, 3));  // done 1
     EXPECT_FALSE(IsValidCommandWords(TypeCommand::DONE, 2));  // done
-    EXPECT_FALSE(IsValidCommandWords(TypeCommand::DONE, 4));   // done 1 extra
+    EXPECT_TRUE(IsValidCommandWords(TypeCommand::DONE, 4));   // done 1 2-5
 }
 
 TEST(IsValidCommandWordsTest, RemoveCommand) {
     EXPECT_TRUE(IsValidCommandWords(TypeCommand::REMOVE, 3));  // remove 1
     EXPECT_FALSE(IsValidCommandWords(TypeCommand::REMOVE, 2));  // remove
-    EXPECT_FALSE(IsValidCommandWords(TypeCommand::REMOVE, 4));  // remove 1 extra
+    EXPECT_TRUE(IsValidCommandWords(TypeCommand::REMOVE, 4));  // remove 1 2-5
 }
 
 TEST(IsValidCommandWordsTest, EditCommand) {
@@ -151,6 +192,32 @@ TEST(ParserTest, ListCompletedCommand) {
     EXPECT_EQ(std::get<ListOption>(parser.GetCommandOption()), ListOption::COMPLETED);
 }
 
+TEST(ParserTest, ListFormatOption) {
+    int argc = 4;
+    char* argv[] = { (char*)"todo", (char*)"list", (char*)"pending", (char*)"--format=ndjson" };
+
+    Parser parser;
+    parser.Parse(argc, argv);
+
+    EXPECT_EQ(parser.GetTypeCommand(), TypeCommand::LIST);
+    EXPECT_EQ(std::get<ListOption>(parser.GetCommandOption()), ListOption::PENDING);
+    EXPECT_EQ(parser.GetOutputFormat(), OutputFormat::NDJSON);
+}
+
+TEST(ParserTest, ListRangeOption) {
+    int argc = 7;
+    char* argv[] = { (char*)"todo", (char*)"list", (char*)"--from", (char*)"10", (char*)"completed",
+                     (char*)"--count", (char*)"5" };
+
+    Parser parser;
+    parser.Parse(argc, argv);
+
+    EXPECT_EQ(parser.GetTypeCommand(), TypeCommand::LIST);
+    EXPECT_EQ(std::get<ListOption>(parser.GetCommandOption()), ListOption::COMPLETED);
+    EXPECT_EQ(parser.GetListRange().from, 10);
+    EXPECT_EQ(parser.GetListRange().count, 5);
+}
+
 TEST(ParserTest, ClearCommand) {
     int argc = 2;
     char* argv[] = { (char*)"todo", (char*)"clear" };
@@ -185,6 +252,41 @@ TEST(ParserTest, RemoveCommand) {
     EXPECT_EQ(parser.GetTaskIndex().value(), 3);
 }
 
+TEST(ParserTest, RemoveMultipleIndices) {
+    int argc = 5;
+    char* argv[] = { (char*)"todo", (char*)"remove", (char*)"9", (char*)"3-5,1",
+                     (char*)"4" };
+
+    Parser parser;
+    parser.Parse(argc, argv);
+
+    EXPECT_EQ(parser.GetTypeCommand(), TypeCommand::REMOVE);
+    const std::vector<size_t> expected = {1, 3, 4, 5, 9};
+    EXPECT_TRUE(std::ranges::equal(parser.GetTaskIndices(), expected));
+    EXPECT_EQ(parser.GetTaskIndex().value(), 1);
+}
+
+TEST(ParseIndicesTest, RangesAndErrors) {
+    std::vector<size_t> indices;
+    const std::string_view words[] = { "1-3,7", "2" };
+    ParseIndices(words, indices);
+    EXPECT_EQ(indices, (std::vector<size_t>{1, 2, 3, 7}));
+
+    // Запятая с пробелом равнозначна запятой или пробелу
+    const std::string_view comma_space[] = { "1,", "2", ",", "4", ",6-7" };
+    ParseIndices(comma_space, indices);
+    EXPECT_EQ(indices, (std::vector<size_t>{1, 2, 4, 6, 7}));
+
+    const std::string_view only_comma[] = { "," };
+    EXPECT_THROW(ParseIndices(only_comma, indices), std::invalid_argument);
+    const std::string_view reversed[] = { "5-2" };
+    EXPECT_THROW(ParseIndices(reversed, indices), std::invalid_argument);
+    const std::string_view empty_item[] = { "1,,2" };
+    EXPECT_THROW(ParseIndices(empty_item, indices), std::invalid_argument);
+    const std::string_view huge[] = { "0-18446744073709551615" };
+    EXPECT_THROW(ParseIndices(huge, indices), std::invalid_argument);
+}
+
 TEST(ParserTest, EditCommand) {
     int argc = 5;
     char* argv[] = { (char*)"todo", (char*)"edit", (char*)"2", (char*)"new", (char*)"description" };
@@ -224,6 +326,44 @@ TEST(ParserTest, ConfigNameCommand) {
     EXPECT_EQ(parser.GetTaskText(), "newname.txt");
 }
 
+TEST(ParserTest, ParseTokenSpan) {
+    const std::vector<std::string_view> args = {"Edit", "4", "new", "text"};
+
+    Parser parser;
+    parser.Parse(args);
+
+    EXPECT_EQ(parser.GetTypeCommand(), TypeCommand::EDIT);
+    EXPECT_EQ(parser.GetTaskIndex().value(), 4);
+    EXPECT_EQ(parser.GetTaskText(), "new text");
+}
+
+TEST(ParserTest, BatchCommand) {
+    int argc = 5;
+    char* argv[] = { (char*)"todo", (char*)"batch", (char*)"script.txt", (char*)"--save-every",
+                     (char*)"100" };
+
+    Parser parser;
+    parser.Parse(argc, argv);
+
+    EXPECT_EQ(parser.GetTypeCommand(), TypeCommand::BATCH);
+    EXPECT_EQ(parser.GetTaskText(), "script.txt");
+    EXPECT_EQ(parser.GetSaveEvery(), 100);
+}
+
+// Тесты для SplitWords
+TEST(SplitWordsTest, QuotesAndSpaces) {
+    std::vector<std::string_view> words;
+    SplitWords("  config path \"/my dir/x\"\t'a b' end ", words);
+
+    ASSERT_EQ(words.size(), 5);
+    EXPECT_EQ(words[0], "config");
+    EXPECT_EQ(words[2], "/my dir/x");
+    EXPECT_EQ(words[3], "a b");
+    EXPECT_EQ(words[4], "end");
+
+    EXPECT_THROW(SplitWords("add \"open", words), std::invalid_argument);
+}
+
 // Тесты для проверки обработки ошибок
 TEST(ParserErrorTest, UnknownCommand) {
     int argc = 2;
@@ -251,6 +391,22 @@ TEST(ParserErrorTest, InvalidListOption) {
     EXPECT_THROW(parser.Parse(argc, argv), std::invalid_argument);
 }
 
+TEST(ParserErrorTest, InvalidListFormat) {
+    int argc = 3;
+    char* argv[] = { (char*)"todo", (char*)"list", (char*)"--format=xml" };
+    
+    Parser parser;
+    EXPECT_THROW(parser.Parse(argc, argv), std::invalid_argument);
+}
+
+TEST(ParserErrorTest, MissingListRangeValue) {
+    int argc = 3;
+    char* argv[] = { (char*)"todo", (char*)"list", (char*)"--count" };
+    
+    Parser parser;
+    EXPECT_THROW(parser.Parse(argc, argv), std::invalid_argument);
+}
+
 TEST(ParserErrorTest, InvalidConfigOption) {
     int argc = 4;
     char* argv[] = { (char*)"todo", (char*)"config", (char*)"invalid", (char*)"value" };
@@ -282,3 +438,41 @@ TEST(ParserErrorTest, InvalidNumberInEdit) {
     Parser parser;
     EXPECT_THROW(parser.Parse(argc, argv), std::invalid_argument);
 }
+
+// Повторный разбор тем же парсером не выделяет память
+TEST(ParserTest, ReparseWithoutAllocations) {
+    int add_argc = 5;
+    char* add_argv[] = { (char*)"todo", (char*)"add", (char*)"buy", (char*)"fresh",
+                         (char*)"milk" };
+    int list_argc = 5;
+    char* list_argv[] = { (char*)"todo", (char*)"LIST", (char*)"Pending", (char*)"--format=JSON",
+                          (char*)"--count=10" };
+
+    Parser parser;
+    parser.Parse(add_argc, add_argv);
+    parser.Parse(list_argc, list_argv);
+
+    const size_t before = g_allocations.load();
+    for (int i = 0; i < 100; ++i) {
+        parser.Parse(add_argc, add_argv);
+        parser.Parse(list_argc, list_argv);
+    }
+    const size_t allocations = g_allocations.load() - before;
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(parser.GetOutputFormat(), OutputFormat::JSON);
+    EXPECT_EQ(parser.GetListRange().count, 10u);
+
+    parser.Parse(add_argc, add_argv);
+    EXPECT_EQ(parser.GetTaskText(), "buy fresh milk");
+}
+
+// Текст из одного слова указывает на исходное слово без копирования
+TEST(ParserTest, SingleWordTextIsView) {
+    const std::string_view args[] = { "add", "milk" };
+
+    Parser parser;
+    parser.Parse(args);
+
+    EXPECT_EQ(parser.GetTaskText().data(), args[1].data());
+}
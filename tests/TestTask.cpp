@@ -78,6 +78,35 @@ TEST_F(TaskManagerTest, Constructor_Success) {
     EXPECT_NO_THROW({ TaskManager manager(config_file_.string()); });
 }
 
+TEST_F(TaskManagerTest, ReadConfig_DoesNotLoadList) {
+    CreateConfigFile(output_dir_.string(), "test_list.json");
+    // Испорченный список не мешает узнать, где он лежит
+    std::ofstream(task_file_) << "not json";
+
+    const ListConfig config = ReadConfig(config_file_.string());
+    EXPECT_EQ(config.path, output_dir_.string());
+    EXPECT_EQ(config.name, "test_list.json");
+    EXPECT_EQ(config.GetFullName(), task_file_.string());
+    EXPECT_THROW(ReadConfig((config_dir_ / "missing.json").string()), std::runtime_error);
+}
+
+TEST_F(TaskManagerTest, FromFile_WithoutConfig) {
+    CreateTaskFile({Task("Task 1", true)});
+
+    TaskManager manager = TaskManager::FromFile(task_file_.string());
+    ASSERT_EQ(manager.GetTasks().size(), 1);
+    EXPECT_TRUE(manager.GetTasks()[0].done);
+    EXPECT_EQ(manager.GetFullName(), task_file_.string());
+
+    // Отсутствующий файл - пустой список, который создается при сохранении
+    const fs::path new_file = output_dir_ / "chats" / "42.json";
+    TaskManager empty = TaskManager::FromFile(new_file.string());
+    EXPECT_TRUE(empty.GetTasks().empty());
+    empty.AddTask("New task");
+    empty.Save();
+    EXPECT_TRUE(fs::exists(new_file));
+}
+
 // Тесты для методов AddTask
 TEST_F(TaskManagerTest, AddTask_String_Success) {
     CreateConfigFile(output_dir_.string(), "test_list.json");
@@ -161,6 +190,57 @@ TEST_F(TaskManagerTest, RemoveTask_InvalidIndex_Throws) {
     EXPECT_THROW({ manager.RemoveTask(5); }, std::out_of_range);
 }
 
+// Тесты для групповых ToggleTasks и RemoveTasks
+TEST_F(TaskManagerTest, RemoveTasks_Success) {
+    CreateConfigFile(output_dir_.string(), "test_list.json");
+
+    TaskManager manager(config_file_.string());
+    for (int i = 0; i < 6; ++i) {
+        manager.AddTask("Task " + std::to_string(i));
+    }
+
+    const std::vector<size_t> indices = {0, 2, 3, 5};
+    EXPECT_NO_THROW({ manager.RemoveTasks(indices); });
+
+    const auto& tasks = manager.GetTasks();
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].text, "Task 1");
+    EXPECT_EQ(tasks[1].text, "Task 4");
+}
+
+TEST_F(TaskManagerTest, ToggleTasks_Success) {
+    CreateConfigFile(output_dir_.string(), "test_list.json");
+
+    TaskManager manager(config_file_.string());
+    manager.AddTask("Task 1");
+    manager.AddTask("Task 2");
+    manager.AddTask("Task 3");
+
+    const std::vector<size_t> indices = {0, 2};
+    manager.ToggleTasks(indices);
+
+    const auto& tasks = manager.GetTasks();
+    EXPECT_TRUE(tasks[0].done);
+    EXPECT_FALSE(tasks[1].done);
+    EXPECT_TRUE(tasks[2].done);
+}
+
+TEST_F(TaskManagerTest, RemoveTasks_InvalidIndices_Throw) {
+    CreateConfigFile(output_dir_.string(), "test_list.json");
+
+    TaskManager manager(config_file_.string());
+    manager.AddTask("Task 1");
+    manager.AddTask("Task 2");
+
+    // Список не меняется, если хотя бы одного номера нет
+    const std::vector<size_t> missing = {0, 5};
+    EXPECT_THROW({ manager.RemoveTasks(missing); }, std::out_of_range);
+    EXPECT_EQ(manager.GetTasks().size(), 2);
+
+    const std::vector<size_t> unsorted = {1, 0};
+    EXPECT_THROW({ manager.RemoveTasks(unsorted); }, std::invalid_argument);
+}
+
 // Тесты для метода EditTask
 TEST_F(TaskManagerTest, EditTask_Success) {
     CreateConfigFile(output_dir_.string(), "test_list.json");
@@ -248,6 +328,58 @@ TEST_F(TaskManagerTest, Save_Success) {
     EXPECT_EQ(j[1]["done"], false);
 }
 
+// Тесты для метода PrintTasks
+TEST_F(TaskManagerTest, PrintTasks_Formats) {
+    CreateConfigFile(output_dir_.string(), "test_list.json");
+
+    TaskManager manager(config_file_.string());
+    manager.AddTask("Task \"1\"");
+    manager.AddTask("Task 2");
+    manager.ToggleTask(1);
+
+    OutputBuffer plain(OutputBuffer::NO_FD);
+    manager.PrintTasks(plain);
+    EXPECT_EQ(plain.GetData(), "0. [ ] Task \"1\"\n1. [x] Task 2\n");
+
+    OutputBuffer completed(OutputBuffer::NO_FD);
+    manager.PrintTasks(completed, true, OutputFormat::JSON);
+    json j = json::parse(completed.GetData());
+    ASSERT_EQ(j.size(), 1);
+    EXPECT_EQ(j[0]["index"], 1);
+    EXPECT_EQ(j[0]["done"], true);
+
+    OutputBuffer ndjson(OutputBuffer::NO_FD);
+    manager.PrintTasks(ndjson, OutputFormat::NDJSON);
+    EXPECT_EQ(ndjson.GetData(),
+              "{\"index\":0,\"text\":\"Task \\\"1\\\"\",\"done\":false}\n"
+              "{\"index\":1,\"text\":\"Task 2\",\"done\":true}\n");
+}
+
+TEST_F(TaskManagerTest, PrintTasks_Range) {
+    CreateConfigFile(output_dir_.string(), "test_list.json");
+
+    TaskManager manager(config_file_.string());
+    for (size_t i = 0; i < 10; ++i) {
+        manager.AddTask("Task " + std::to_string(i));
+    }
+    manager.ToggleTask(3);
+    manager.ToggleTask(5);
+    manager.ToggleTask(7);
+
+    OutputBuffer window(OutputBuffer::NO_FD);
+    EXPECT_EQ(manager.PrintTasks(window, std::nullopt, ListRange{8, 5}), 2);
+    EXPECT_EQ(window.GetData(), "8. [ ] Task 8\n9. [ ] Task 9\n");
+
+    OutputBuffer completed(OutputBuffer::NO_FD);
+    EXPECT_EQ(manager.PrintTasks(completed, true, ListRange{1, 1}), 1);
+    EXPECT_EQ(completed.GetData(), "5. [x] Task 5\n");
+
+    OutputBuffer empty(OutputBuffer::NO_FD);
+    EXPECT_EQ(manager.PrintTasks(empty, std::nullopt, ListRange{20, 5}), 0);
+    EXPECT_EQ(manager.CountTasks(true), 3);
+    EXPECT_EQ(manager.CountTasks(false), 7);
+}
+
 // Тесты для метода LoadTasksFromFile
 TEST_F(TaskManagerTest, LoadTasksFromFile_Success) {
     // Подготавливаем тестовые данные
@@ -518,6 +650,35 @@ TEST_F(TaskManagerTest, ClearTasks_EmptyList_Success) {
     EXPECT_EQ(manager.GetTasks().size(), 0);
 }
 
+// Тесты для версий списка
+TEST_F(TaskManagerTest, Version_MarksChangedTasks) {
+    TaskManager manager = TaskManager::FromJson(json::array(), task_file_.string());
+    const uint64_t empty = manager.GetVersion();
+
+    manager.AddTask("Task 1");
+    manager.AddTask("Task 2");
+    manager.AddTask("Task 3");
+    const std::vector<Task>& tasks = manager.GetTasks();
+    EXPECT_EQ(tasks[2].revision, manager.GetVersion());
+    EXPECT_GT(manager.GetVersion(), empty);
+
+    // Изменение помечает только затронутую задачу
+    const uint64_t first = tasks[0].revision;
+    manager.ToggleTask(1);
+    EXPECT_EQ(tasks[1].revision, manager.GetVersion());
+    EXPECT_EQ(tasks[0].revision, first);
+
+    // Удаление меняет версию, а сдвинутые задачи сохраняют свою
+    const uint64_t last = tasks[2].revision;
+    manager.RemoveTask(0);
+    EXPECT_GT(manager.GetVersion(), tasks[0].revision);
+    EXPECT_EQ(tasks[1].revision, last);
+
+    const uint64_t before_clear = manager.GetVersion();
+    manager.ClearTasks();
+    EXPECT_GT(manager.GetVersion(), before_clear);
+}
+
 }  // namespace task
 
 int main(int argc, char** argv) {
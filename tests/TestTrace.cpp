@@ -0,0 +1,151 @@
+#include "Parser.hpp"
+#include "Trace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace trace {
+
+using json = nlohmann::json;
+
+// Трассировка глобальная: каждый тест начинает с пустых буферов
+class TraceTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        if (!COMPILED_IN) {
+            GTEST_SKIP() << "Tracing is disabled at compile time";
+        }
+        Clear();
+        Enable();
+    }
+
+    void TearDown() override {
+        Enable(false);
+        Clear();
+    }
+
+    static json Export() {
+        std::ostringstream out;
+        WriteChromeTrace(out);
+        return json::parse(out.str());
+    }
+
+    static std::vector<json> FindEvents(const json& trace, std::string_view name) {
+        std::vector<json> events;
+        for (const json& event : trace["traceEvents"]) {
+            if (event["ph"] == "X" && event["name"] == name) {
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+};
+
+TEST_F(TraceTest, DisabledTracingRecordsNothing) {
+    Enable(false);
+    {
+        Span span("test", "ignored");
+    }
+    EXPECT_FALSE(IsEnabled());
+    EXPECT_EQ(GetEventCount(), 0u);
+}
+
+TEST_F(TraceTest, ExportsSpansAsChromeTrace) {
+    {
+        Span outer("test", "outer");
+        Span inner("test", "inner");
+    }
+    std::thread worker([] {
+        SetThreadName("test \"worker\"");
+        Span span("test", "worker");
+    });
+    worker.join();
+    EXPECT_EQ(GetEventCount(), 3u);
+
+    const json trace = Export();
+    const std::vector<json> outer = FindEvents(trace, "outer");
+    const std::vector<json> inner = FindEvents(trace, "inner");
+    const std::vector<json> in_worker = FindEvents(trace, "worker");
+    ASSERT_EQ(outer.size(), 1u);
+    ASSERT_EQ(inner.size(), 1u);
+    ASSERT_EQ(in_worker.size(), 1u);
+
+    // Вложенный участок лежит внутри внешнего и в том же потоке
+    EXPECT_EQ(outer[0]["cat"], "test");
+    EXPECT_EQ(outer[0]["tid"], inner[0]["tid"]);
+    EXPECT_LE(outer[0]["ts"].get<double>(), inner[0]["ts"].get<double>());
+    EXPECT_GE(outer[0]["dur"].get<double>(), inner[0]["dur"].get<double>());
+    EXPECT_NE(outer[0]["tid"], in_worker[0]["tid"]);
+
+    bool named = false;
+    for (const json& event : trace["traceEvents"]) {
+        if (event["ph"] == "M" && event["tid"] == in_worker[0]["tid"]) {
+            named = event["args"]["name"] == "test \"worker\"";
+        }
+    }
+    EXPECT_TRUE(named);
+}
+
+TEST_F(TraceTest, ExportsAsyncSpansOnOwnTracks) {
+    // Два запроса на одном потоке пересекаются, как корутины на io_context
+    auto first = std::make_unique<AsyncSpan>("test", "first");
+    auto second = std::make_unique<AsyncSpan>("test", "second");
+    first.reset();
+    second.reset();
+    EXPECT_EQ(GetEventCount(), 2u);
+
+    const json trace = Export();
+    EXPECT_TRUE(FindEvents(trace, "first").empty());
+    std::vector<json> begins;
+    std::vector<json> ends;
+    for (const json& event : trace["traceEvents"]) {
+        if (event["ph"] == "b") {
+            begins.push_back(event);
+        } else if (event["ph"] == "e") {
+            ends.push_back(event);
+        }
+    }
+    ASSERT_EQ(begins.size(), 2u);
+    ASSERT_EQ(ends.size(), 2u);
+
+    // Каждое начало закрывает конец с тем же номером, номера у запросов разные
+    EXPECT_NE(begins[0]["id"], begins[1]["id"]);
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(begins[i]["id"], ends[i]["id"]);
+        EXPECT_EQ(begins[i]["name"], ends[i]["name"]);
+        EXPECT_EQ(begins[i]["cat"], "test");
+        EXPECT_LE(begins[i]["ts"].get<double>(), ends[i]["ts"].get<double>());
+    }
+}
+
+TEST_F(TraceTest, RingKeepsLatestEvents) {
+    std::thread worker([] {
+        for (size_t i = 0; i < RING_SIZE + 10; ++i) {
+            Span span("test", i < 10 ? "old" : "new");
+        }
+    });
+    worker.join();
+
+    EXPECT_EQ(GetEventCount(), RING_SIZE);
+    const json trace = Export();
+    EXPECT_TRUE(FindEvents(trace, "old").empty());
+    EXPECT_EQ(FindEvents(trace, "new").size(), RING_SIZE);
+}
+
+TEST_F(TraceTest, ParserIsInstrumented) {
+    const std::vector<std::string_view> args = {"add", "Купить", "хлеб"};
+    parser::Parser parser;
+    parser.Parse(args);
+
+    EXPECT_EQ(FindEvents(Export(), "Parser::Parse").size(), 1u);
+}
+
+}  // namespace trace